@@ -0,0 +1,37 @@
+#ifndef ANIMATION_H
+#define ANIMATION_H
+
+#include <cstddef>
+#include <cstdint>
+
+/**
+ * @brief The global animation clock, the number of frames drawn so far.
+ *
+ * Only advanced by animationAdvance() between frames, so the simulation and
+ * drawing can read it without synchronization.
+ */
+extern uint32_t animationTick;
+
+/**
+ * @brief Advances the animation clock by one frame.
+ *
+ * Called once per frame after drawing, never from inside a draw call.
+ */
+void animationAdvance();
+
+/**
+ * @brief Returns the frame an animated entity shows at the current animation tick.
+ *
+ * Entities keep no animation state beyond their phase, so nothing is done per
+ * entity until its frame is needed for drawing.
+ *
+ * @param phase The animation tick the entity's animation started on.
+ * @param ticksPerFrame The number of ticks each frame is shown for.
+ * @param frameCount The number of frames in the animation.
+ * @return size_t The frame index, less than frameCount.
+ */
+inline size_t getAnimationFrame(uint32_t phase, uint32_t ticksPerFrame, size_t frameCount) {
+    return (animationTick - phase) / ticksPerFrame % frameCount;
+}
+
+#endif
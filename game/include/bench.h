@@ -0,0 +1,47 @@
+#ifndef BENCH_H
+#define BENCH_H
+
+#include <string>
+
+/**
+ * @struct BenchConfig
+ * @brief Settings for a headless micro-benchmark run.
+ */
+struct BenchConfig {
+    std::string name; ///< The benchmark to run.
+    int count = 0; ///< The problem size, or 0 for the benchmark's default.
+    int ticks = 600; ///< The number of ticks or iterations to time.
+};
+
+/**
+ * @brief Parses the benchmark command line options.
+ *
+ * Recognizes --bench <name> [count] and --bench-ticks <ticks>.
+ *
+ * @param argc The number of command line arguments.
+ * @param argv The command line arguments.
+ * @param config Receives the parsed settings.
+ * @return true if a benchmark was requested, false otherwise.
+ */
+bool parseBenchArgs(int argc, char* argv[], BenchConfig& config);
+
+/**
+ * @brief Runs a benchmark without a window and prints its timings.
+ *
+ * The heads benchmark moves a centipede split into many chains with head
+ * moves computed serially, in parallel and serially on the runtime playfield
+ * fallback, and checks all three runs end in the identical state. The collision benchmark times FixedRect::intersects
+ * loops against the batched BoxArray kernel and checks both find the same hits.
+ * The mushrooms benchmark times shuffling every cell of a huge field against
+ * the sampled uniform and blue-noise layouts, and checks the sampled fields
+ * are reproducible and keep their spacing. The render benchmark times the
+ * software render backend at the native window size, with the field layer
+ * cached and recomposited every frame, and checks the SSE2 and scalar span
+ * kernels render identical frames.
+ *
+ * @param config The benchmark settings.
+ * @return int 0 on success, 1 if the benchmark is unknown or its results were inconsistent.
+ */
+int runBench(const BenchConfig& config);
+
+#endif
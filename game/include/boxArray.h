@@ -0,0 +1,122 @@
+#ifndef BOXARRAY_H
+#define BOXARRAY_H
+
+#include <cstdint>
+#include <vector>
+#include "fixedPoint.h"
+
+/**
+ * @class BoxArray
+ * @brief Axis-aligned boxes packed as separate coordinate arrays for batched intersection tests.
+ *
+ * Each box stores its fixed-point left, top, right and bottom edges in its own
+ * array so a query box can be tested against 8 boxes at once with AVX2, or 4 with SSE2,
+ * falling back to a scalar loop elsewhere. The kernel is chosen at compile
+ * time, see the CENTIPEDE_AVX2 build option. Every box also carries an id,
+ * typically the entity index of the object it was taken from.
+ *
+ * Intersection matches FixedRect::intersects: boxes that only touch along an
+ * edge do not intersect.
+ */
+class BoxArray {
+    public:
+        /**
+         * @brief Removes all boxes, keeping the allocated storage.
+         */
+        void clear();
+
+        /**
+         * @brief Appends a box.
+         *
+         * @param box The box to append, with a positive width and height.
+         * @param id The id stored with the box.
+         */
+        void push(const FixedRect& box, uint32_t id);
+
+        /**
+         * @brief Returns the index of the first box at or after start that intersects a query box.
+         *
+         * @param query The box to test.
+         * @param start The index to start searching from.
+         * @return size_t The index of the first intersecting box, or size() if none intersects.
+         */
+        size_t firstHit(const FixedRect& query, size_t start = 0) const;
+
+        /**
+         * @brief Sets one bit per box that intersects a query box.
+         *
+         * Bit i % 64 of mask[i / 64] is set when box i intersects. All other bits are cleared.
+         *
+         * @param query The box to test.
+         * @param mask Receives maskWords() words.
+         */
+        void hitMask(const FixedRect& query, uint64_t* mask) const;
+
+        /**
+         * @brief Returns the number of 64-bit words hitMask() writes.
+         */
+        size_t maskWords() const {return (count + 63) / 64;};
+
+        /**
+         * @brief Returns the id stored with a box.
+         *
+         * @param index The index of the box.
+         */
+        uint32_t getId(size_t index) const {return ids[index];};
+
+        /**
+         * @brief Returns a box.
+         *
+         * @param index The index of the box.
+         */
+        FixedRect getBox(size_t index) const {
+            return {lefts[index], tops[index], rights[index] - lefts[index], bottoms[index] - tops[index]};
+        };
+
+        /**
+         * @brief Returns the number of boxes.
+         */
+        size_t size() const {return count;};
+
+        /**
+         * @brief Turns counting box tests on or off, off by default so queries stay free of it.
+         *
+         * @param counting true to count the box tests of every query from now on.
+         */
+        static void setTestCounting(bool counting);
+
+        /**
+         * @brief Returns the number of box tests performed by every BoxArray while counting was on.
+         *
+         * Whole blocks are counted, padding included, since the kernel tests them all.
+         * Each thread counts into its own counter, summed here, so call it once
+         * per tick rather than per query.
+         */
+        static uint64_t getTestCount();
+
+        /**
+         * @brief Returns the name of the kernel compiled in, "avx2", "sse2" or "scalar".
+         */
+        static const char* kernelName();
+
+    private:
+        /**
+         * @brief Tests the query against one block of boxes.
+         *
+         * @param query The query edges: left, top, right, bottom.
+         * @param block The index of the first box of the block, a multiple of blockSize.
+         * @return uint32_t One bit per box of the block that intersects.
+         */
+        uint32_t testBlock(const Fixed* query, size_t block) const;
+
+        static const size_t blockSize = 8; ///< Boxes per kernel step, the arrays are padded to a multiple of it.
+
+        std::vector<Fixed> lefts; ///< The left edge of every box.
+        std::vector<Fixed> tops; ///< The top edge of every box.
+        std::vector<Fixed> rights; ///< The right edge of every box.
+        std::vector<Fixed> bottoms; ///< The bottom edge of every box.
+        std::vector<uint32_t> ids; ///< The id of every box.
+        size_t count = 0; ///< The number of boxes, not counting padding.
+};
+
+#endif
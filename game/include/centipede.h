@@ -2,322 +2,388 @@
 #define CENTIPEDE_H
 
 #include <SFML/Graphics.hpp>
-#include <list>
 #include <tuple>
-#include <queue>
+#include <vector>
 #include "mushroom.h"
 #include "globals.h"
+#include "boxArray.h"
+#include "entities.h"
+#include "flowField.h"
 #include "laserBlaster.h"
+#include "playfield.h"
+#include "spriteBatch.h"
 
 using namespace sf;
 
 /**
- * @class ECE_CentipedeSegment
- * @brief Represents a segment of a centipede in the game.
+ * @class MoveQueue
+ * @brief A FIFO of delayed moves backed by a ring buffer.
  * 
- * This class is responsible for handling the behavior and properties of a centipede segment,
- * including movement, collision detection, and texture orientation.
+ * A segment pushes and pops one move every tick, so once the ring has grown to
+ * the segment's delay it never allocates again.
  */
-class ECE_CentipedeSegment : public Sprite {
+class MoveQueue {
     public:
+        using Move = std::tuple<Fixed, Fixed, int, int>; ///< The fixed-point x and y, and the dx and dy of a move.
+
         /**
-         * @brief Constructs a new ECE_CentipedeSegment object.
+         * @brief Appends a move to the back of the queue, growing the ring if it is full.
          * 
-         * @param isHead A boolean indicating whether this segment is the head of the centipede.
-         * @param initialSpeed The initial speed of the centipede.
+         * @param move The move to append.
          */
-        ECE_CentipedeSegment(bool isHead, int initialSpeed);
+        void push(const Move& move);
 
         /**
-         * @brief Moves the head of the centipede.
+         * @brief Removes the move at the front of the queue.
          */
-        void headMove();
+        void pop() {head = (head + 1) % ring.size(); count--;};
 
         /**
-         * @brief Checks for collisions with the centipede and determine the next move.
+         * @brief Returns the move at the front of the queue.
+         * 
+         * @return Move The oldest queued move.
          */
-        void checkCollisions();
-
+        const Move& front() const {return ring[head];};
 
         /**
-         * @brief Checks if a head segment can move to a given bounds without collisions
-         *        excluding its trailing bodies.
+         * @brief Returns the number of queued moves.
          * 
-         * @param bounds The area of interest.
-         * @return true if moving to bounds will not result in a collision, false otherwise.
+         * @return size_t The number of queued moves.
          */
-        bool segmentCanMove(FloatRect bounds);
+        size_t size() const {return count;};
 
         /**
-         * @brief Returns the trailing bodies of the centipede segment.
+         * @brief Preallocates room for a number of moves.
          * 
-         * @param segment The segment to find the trailing bodies of.
-         * @return std::list<ECE_CentipedeSegment> The trailing bodies of the segment.
+         * @param capacity The number of moves to make room for.
          */
-        std::list<ECE_CentipedeSegment> getTrailingBodies(ECE_CentipedeSegment& segment);
+        void reserve(size_t capacity);
+
+    private:
+        std::vector<Move> ring; ///< The ring buffer storage.
+        size_t head = 0; ///< The index of the oldest move.
+        size_t count = 0; ///< The number of queued moves.
+};
+
+/**
+ * @struct SegmentState
+ * @brief The AI state of a centipede segment, beyond the direction and speed of its Motion.
+ */
+struct SegmentState {
+    SegmentType type; ///< Whether the segment leads its chain or follows the segment before it.
+    int savedDy = 0; ///< The vertical direction saved for when a head gets stuck.
+    int randomWalkDy = 0; ///< The vertical direction for random walk.
+    int maxDelayTicks = 0; ///< The number of moves a body trails the segment before it by.
+    MoveQueue moves; ///< The moves a body takes once they are maxDelayTicks old.
+    Orientation facing = Orientation::NONE; ///< The orientation the segment's texture should face.
+};
 
+/**
+ * @class ECE_Centipede
+ * @brief Represents a centipede in the game, composed of multiple segments.
+ * 
+ * Every segment is an entity with a Placement, a Collider the size of its first
+ * texture, a Health of 1 while alive, a Renderable, an Animation of the head or
+ * body frames, a Motion and a SegmentState. The centipede holds the systems
+ * that move, turn and draw the segments from those components.
+ */
+class ECE_Centipede {
+    public:
         /**
-         * @brief Moves the body of the centipede.
+         * @brief Constructs a new ECE_Centipede object with a specified number of segments.
          * 
-         * @param dx The horizontal direction to move.
-         * @param dy The vertical direction to move.
-         * @param x The x-coordinate of the destination.
-         * @param y The y-coordinate of the destination.
+         * @param segmentCount The number of segments in the centipede.
+         * @param initialSpeed The initial speed of the centipede.
          */
-        void bodyMove(int dx, int dy, float x, float y);
+        ECE_Centipede(int segmentCount, int initialSpeed);
 
         /**
-         * @brief Returns the type of the segment.
-         * 
-         * @return SegmentType The type of the segment.
+         * @brief Moves the centipede.
          */
-        SegmentType getType() {return type;};
+        void move();
 
         /**
-         * @brief Sets the type of the segment.
-         * 
-         * @param type The new type of the segment.
+         * @brief Resets the centipede to its initial state.
          */
-        void setType(SegmentType type) {this->type = type;};
+        void reset(bool resetSpeed=true);
 
         /**
-         * @brief Sets the direction of the segment.
-         * 
-         * @param dx The horizontal direction.
-         * @param dy The vertical direction.
+         * @brief Draws the centipede with the selected render backend.
          */
-        void setDirection(int dx, int dy) {this->dx = dx; this->dy = dy;};
+        void draw();
 
         /**
-         * @brief Returns the direction of the segment.
-         * 
-         * @return std::tuple<int, int> The horizontal and vertical directions.
+         * @brief Turns the renderable of every living segment whose facing changed.
          */
-        std::tuple<int, int> getDirection() {return std::make_tuple(dx, dy);};
+        void applyOrientations();
 
         /**
-         * @brief Returns the next segment's bounds based on the current direction.
-         * 
-         * @param useDx The horizontal direction to use.
-         * @param useDy The vertical direction to use.
-         * @return FloatRect The bounds of the next segment.
+         * @brief Returns the number of segments turned by applyOrientations() so far.
+         *
+         * @return uint64_t The number of orientation updates.
          */
-        FloatRect getNextSegmentBounds(int useDx=999, int useDy=999);
+        uint64_t getOrientationUpdates() {return orientationUpdates;};
 
         /**
-         * @brief Returns the ID of the segment.
+         * @brief Returns the segments in the centipede.
          * 
-         * @return int The ID of the segment.
+         * Segments are created in chain order and only ever destroyed all
+         * together, so the entity indices follow the chains and each
+         * component array holds the segments in chain order.
+         * 
+         * @return EntityStore The segments.
          */
-        int getId() {return id;};
+        EntityStore& getSegments() {return segments;};
 
         /**
-         * @brief To check if two given segments are the same.
+         * @brief Returns the AI state of every segment.
          * 
-         * @param id The new ID of the other segment.
+         * @return ComponentArray<SegmentState> The segment states.
          */
-        bool operator==(const ECE_CentipedeSegment& other) const {return id == other.id;};
+        ComponentArray<SegmentState>& getSegmentStates() {return segmentStates;};
 
         /**
-         * @brief Updates the texture orientation based on the current direction.
+         * @brief Checks if a segment is alive.
+         * 
+         * @param segment The segment, which may be the null entity.
+         * @return true if the segment is live and has health left, false otherwise.
          */
-        void updateTextureOrientation();
+        bool isLiving(Entity segment) const {
+            const Health* health = segments.healths.get(segment);
+            return health && health->hitPoints > 0;
+        };
 
         /**
-         * @brief Sets the status of the segment.
+         * @brief Kills a segment and promotes the next living segment in its chain to a head.
+         * 
+         * Keeps the live count and chain heads up to date so they never need to be
+         * recomputed from a full scan of the segments.
          * 
-         * @param status The new status of the segment.
+         * @param segment The living segment to kill.
          */
-        void setStatus(CharacterStatus status) {this->status = status;};
+        void killSegment(Entity segment);
 
         /**
-         * @brief Returns the status of the segment.
+         * @brief Returns the number of living segments.
          * 
-         * @return CharacterStatus The status of the segment.
+         * @return int The number of living segments.
          */
-        CharacterStatus getStatus() {return status;};
+        int getLiveCount() {return liveCount;};
 
         /**
-         * @brief Switches texture to next animation.
+         * @brief Checks if any segment of the centipede is still alive.
+         * 
+         * @return bool True if at least one segment is alive, false otherwise.
          */
-        void animate();
+        bool isAlive() {return liveCount > 0;};
 
         /**
-         * @brief Returns the animation texture index of the segment.
+         * @brief Returns the bounds of every living segment as of the start of the current move.
+         * 
+         * Heads decide their moves against this snapshot rather than the live segments,
+         * so every head sees the same state no matter the order they are processed in.
          * 
-         * @return int The texture index of the segment.
+         * @return const BoxArray& The segment bounds in chain order, each box's id the segment's entity index.
          */
-        int getTextureIndex() {return textureIndex;};
+        const BoxArray& getOccupancy() {return occupancy;};
 
         /**
-         * @brief Finds and returns a list of all open spots.
+         * @brief Returns the current bounds of every living segment, packed for batched collision tests.
+         * 
+         * The boxes are rebuilt on the first call after the centipede moves, is
+         * reset or loses a segment. Readers may call it concurrently with each
+         * other, but not with any of those changes.
          * 
-         * @return std::vector<sf::Vector2f> List of all open spots.
+         * @return const BoxArray& The segment bounds in chain order, each box's id the segment's entity index.
          */
-        std::vector<sf::Vector2f> findOpenSpots();
+        const BoxArray& getSegmentBoxes();
 
         /**
-         * @brief Finds the closest open spot to the segment.
+         * @brief Sets the number of heads at which head moves are computed in parallel.
          * 
-         * @return sf::Vector2f The closest open spot.
+         * The result is identical either way, only the throughput differs.
+         * 
+         * @param threshold The minimum number of heads to parallelize, 0 to never parallelize.
          */
-        sf::Vector2f findClosestOpenSpot();
+        void setParallelHeadThreshold(size_t threshold) {parallelHeadThreshold = threshold;};
 
         /**
-         * @brief Sets the speed of the segment.
+         * @brief Returns the entity indices of the living chain heads in chain order.
          * 
-         * @param speed The new speed of the segment.
+         * @return std::vector<uint32_t> The entity indices of the heads.
          */
-        void setSpeed(int speed) {this->speed = speed;};
-
+        const std::vector<uint32_t>& getHeads() {return heads;};
+        
         /**
-         * @brief Returns the speed of the segment.
+         * @brief Sets the speed of the centipede.
          * 
-         * @return float The speed of the segment.
+         * @param speed The new speed of the centipede.
          */
-        int getSpeed() {return speed;};
+        void setSpeed(int speed);
 
         /**
-         * @brief Sets the maximum delay ticks for the segment.
+         * @brief Returns the speed of the centipede.
          * 
-         * @param maxDelayTicks The new maximum delay ticks.
+         * @return int The speed of the centipede.
          */
-        void setMaxDelayTicks(int maxDelayTicks) {this->maxDelayTicks = maxDelayTicks;};
+        int getSpeed() {return speed;};
 
         /**
-         * @brief Returns the maximum delay ticks of the segment.
+         * @brief Sets the random walk behavior of the centipede.
          * 
-         * @return int The maximum delay ticks of the segment.
+         * @param randomWalk A boolean indicating whether the centipede should randomly walk.
          */
-        int getMaxDelayTicks() {return maxDelayTicks;};
+        void setRandomWalk(bool randomWalk);
 
         /**
-         * @brief Returns the moves queue of the segment.
+         * @brief Returns the random walk behavior of the centipede.
          * 
-         * @return std::queue<std::tuple<float, float, int, int>> The moves queue.
+         * @return bool A boolean indicating whether the centipede should randomly walk.
          */
-        std::queue<std::tuple<float, float, int, int>>& getMoves() {return moves;};
+        bool getRandomWalk() {return randomWalk;};
 
         /**
-         * @brief Sets the saved vertical direction of the segment.
+         * @brief Returns the field steering the heads towards the player.
          * 
-         * @param savedDy The new saved vertical direction.
+         * @return const FlowField& The field, brought up to date at the start of every move.
          */
-        void setSavedDy(int savedDy) {this->savedDy = savedDy;};
+        const FlowField& getFlowField() const {return flowField;};
+
+    private:
+        struct SegmentView;
 
         /**
-         * @brief Sets the vertical direction during random walk.
+         * @brief Looks up the components one segment moves with.
          * 
-         * @param randomWalkDy The new random walk veritcal direction.
+         * @param index The entity index of the segment.
+         * @return SegmentView The segment's components.
          */
-        void setRandomWalkDy(int randomWalkDy) {this->randomWalkDy = randomWalkDy;};
+        SegmentView viewSegment(uint32_t index);
 
         /**
-         * @brief Returns the vertical direction during random walk.
-         * 
-         * @return int The vertical direction for random walk.
+         * @brief Checks for collisions ahead of a head and determines its next move.
+         *
+         * @param segment The head.
+         * @param field The playfield geometry, see withPlayfield().
          */
-        int getRandomWalkDy() {return randomWalkDy;};
+        template <typename Playfield>
+        void checkCollisions(SegmentView& segment, const Playfield& field);
 
-    private:
-        SegmentType type; ///< The type of the segment.
-        int dx, dy; ///< The horizontal and vertical directions.
-        int savedDy; ///< The saved vertical direction for when a head gets stuck.
-        int speed; ///< The speed of the segment.
-        int delayTicks, maxDelayTicks; ///< The delay ticks for the segment.
-        std::queue<std::tuple<float, float, int, int>> moves; ///< The moves queue for the segment.
-        int id; ///< The ID of the segment.
-        CharacterStatus status; ///< The status of the segment.
-        int textureIndex; ///< The texture index of the segment.
-        int animationTick; ///< The animation tick of the segment.
-        int randomWalkDy; ///< The vertical direction for random walk.
-};
+        /**
+         * @brief Moves a head one step in its direction.
+         *
+         * @param segment The head.
+         * @param field The playfield geometry, see withPlayfield().
+         */
+        template <typename Playfield>
+        void headMove(SegmentView& segment, const Playfield& field);
 
-/**
- * @class ECE_Centipede
- * @brief Represents a centipede in the game, composed of multiple segments.
- * 
- * The ECE_Centipede class inherits from the Sprite class and manages a centipede
- * entity in the game. It provides functionalities to move, reset, and draw the centipede,
- * as well as access its segments.
- */
-class ECE_Centipede : public Sprite {
-    public:
         /**
-         * @brief Constructs a new ECE_Centipede object with a specified number of segments.
+         * @brief Moves a body to the oldest of its queued moves, queueing the move of the segment before it.
          * 
-         * @param segmentCount The number of segments in the centipede.
-         * @param initialSpeed The initial speed of the centipede.
+         * @param segment The body.
+         * @param dx The horizontal direction of the segment before it.
+         * @param dy The vertical direction of the segment before it.
+         * @param position The position of the segment before it.
          */
-        ECE_Centipede(int segmentCount, int initialSpeed);
+        void bodyMove(SegmentView& segment, int dx, int dy, FixedVec position);
 
         /**
-         * @brief Moves the centipede.
+         * @brief Returns a segment's bounds after one step in a direction.
+         * 
+         * @param segment The segment.
+         * @param useDx The horizontal direction to use, 999 for the segment's own.
+         * @param useDy The vertical direction to use, 999 for the segment's own.
+         * @return FixedRect The bounds after the step.
          */
-        void move();
+        FixedRect getNextSegmentBounds(const SegmentView& segment, int useDx=999, int useDy=999);
 
         /**
-         * @brief Resets the centipede to its initial state.
+         * @brief Records the orientation a segment should face from its direction.
+         *
+         * Only sets the segment's facing, its renderable is turned by applyOrientations().
+         * 
+         * @param segment The segment.
          */
-        void reset(bool resetSpeed=true);
+        static void updateFacing(SegmentView& segment);
 
         /**
-         * @brief Draws the centipede on the window.
+         * @brief Checks if a head can move to a given bounds without collisions
+         *        excluding its trailing bodies.
+         * 
+         * @param index The entity index of the head.
+         * @param bounds The area of interest.
+         * @return true if moving to bounds will not result in a collision, false otherwise.
          */
-        void draw();
+        bool segmentCanMove(uint32_t index, FixedRect bounds);
 
         /**
-         * @brief Returns the list of segments in the centipede.
+         * @brief Returns the entity index one past the last trailing body of a segment.
          * 
-         * @return std::list<ECE_CentipedeSegment> The list of segments.
+         * The trailing bodies of a segment are the consecutive living bodies in
+         * the entity indices directly after it.
+         * 
+         * @param index The entity index of the segment.
+         * @return uint32_t The end of the trailing body range.
          */
-        std::list<ECE_CentipedeSegment>& getSegments() {return segments;};
-        
+        uint32_t getTrailingEnd(uint32_t index);
+
         /**
-         * @brief Sets the speed of the centipede.
+         * @brief Checks if an area overlaps a segment in the occupancy snapshot other than one segment and its trailing bodies.
          * 
-         * @param speed The new speed of the centipede.
+         * @param index The entity index of the segment.
+         * @param bounds The area to check.
+         * @param trailingEnd The end of the segment's trailing body range from getTrailingEnd().
+         * @return true if another segment is in the way, false otherwise.
          */
-        void setSpeed(int speed);
+        bool hitsOtherSegment(uint32_t index, const FixedRect& bounds, uint32_t trailingEnd);
 
         /**
-         * @brief Returns the speed of the centipede.
+         * @brief Checks if a grid spot is free of mushrooms and segments other than one segment and its trailing bodies.
          * 
-         * @return int The speed of the centipede.
+         * @param index The entity index of the segment.
+         * @param spotBounds The bounds of the spot.
+         * @param trailingEnd The end of the segment's trailing body range from getTrailingEnd().
+         * @return true if the spot is open, false otherwise.
          */
-        int getSpeed() {return speed;};
+        bool isOpenSpot(uint32_t index, const FixedRect& spotBounds, uint32_t trailingEnd);
 
         /**
-         * @brief Sets the random walk behavior of the centipede.
+         * @brief Finds the closest open spot to a segment.
          * 
-         * @param randomWalk A boolean indicating whether the centipede should randomly walk.
+         * @param segment The segment.
+         * @param field The playfield geometry, see withPlayfield().
+         * @return FixedVec The closest open spot.
          */
-        void setRandomWalk(bool randomWalk);
+        template <typename Playfield>
+        FixedVec findClosestOpenSpot(const SegmentView& segment, const Playfield& field);
 
         /**
-         * @brief Returns the random walk behavior of the centipede.
+         * @brief Creates a fresh segment chain of the configured length.
          * 
-         * @return bool A boolean indicating whether the centipede should randomly walk.
+         * @param segmentSpeed The speed of the new segments.
          */
-        bool getRandomWalk() {return randomWalk;};
+        void spawnSegments(int segmentSpeed);
 
-    private:
-        std::list<ECE_CentipedeSegment> segments; ///< The list of segments in the centipede.
+        EntityStore segments; ///< The segments in the centipede, in chain order.
+        ComponentArray<SegmentState> segmentStates; ///< The AI state of every segment, cleared along with the segments.
         int length; ///< The number of segments in the centipede.
         int initialSpeed; ///< The initial speed of the centipede.
         int speed; ///< The speed of the centipede.
         bool randomWalk; ///< A boolean indicating whether the centipede should randomly walk.
+        int liveCount; ///< The number of living segments.
+        BoxArray occupancy; ///< The segment bounds at the start of the current move.
+        BoxArray segmentBoxes; ///< The current segment bounds, valid while segmentBoxesStale is false.
+        bool segmentBoxesStale = true; ///< Whether a segment moved or died since segmentBoxes was built.
+        std::vector<FixedVec> headPositions; ///< The head positions at the start of the current move.
+        size_t parallelHeadThreshold = 8; ///< The number of heads at which head moves run in parallel.
+        std::vector<uint32_t> heads; ///< The entity indices of the living chain heads, sorted.
+        uint64_t orientationUpdates = 0; ///< The number of segments turned by applyOrientations().
+        SpriteBatch batch; ///< The segment quads of the frame being drawn.
+        FlowField flowField; ///< The distances of the grid cells to the player row.
 };
 
 
-/**
- * @brief Determines the sign of a given floating-point value.
- *
- * @param value The floating-point value whose sign is to be determined.
- * @return An integer representing the sign of the input value.
- */
-int getSign(float value);
-
 /**
  * @brief Initializes the textures and centipede entity.
  * 
@@ -326,6 +392,11 @@ int getSign(float value);
  */
 void centipedeInit(int length, int initialSpeed);
 
+/**
+ * @brief Prints how many times the centipede's flow field was recomputed.
+ */
+void reportFlowField();
+
 extern std::vector<Texture> headTextures, bodyTextures;
 extern ECE_Centipede centipede;
 
@@ -0,0 +1,92 @@
+#ifndef COLLISIONEVENTS_H
+#define COLLISIONEVENTS_H
+
+#include <cstdint>
+#include <vector>
+#include "entities.h"
+
+/**
+ * @brief What a collision event reports.
+ */
+enum class CollisionKind : uint8_t {
+    PLAYER_HIT, ///< The centipede or the spider reached the player.
+    BLAST_MUSHROOM, ///< A laser blast hit a mushroom, the target.
+    BLAST_SEGMENT, ///< A laser blast hit a centipede segment, the target.
+    BLAST_SPIDER, ///< A laser blast hit the spider.
+    SPIDER_MEAL ///< The spider overlaps a mushroom, the target.
+};
+
+/**
+ * @struct CollisionEvent
+ * @brief A collision found by a detection pass, applied later by resolveCollisions().
+ *
+ * Entities are generational, so an event whose blast or target was removed by
+ * an earlier event of the same tick is recognized as stale and skipped.
+ */
+struct CollisionEvent {
+    CollisionKind kind; ///< What collided.
+    Entity blast; ///< The laser blast, for the BLAST_ kinds.
+    Entity target; ///< The mushroom entity or centipede segment hit, for the kinds naming one.
+};
+
+/**
+ * @class CollisionQueue
+ * @brief The events one detection pass found during a tick.
+ *
+ * Cleared without freeing, so once it has grown to a tick's worth of events
+ * it never allocates again.
+ */
+class CollisionQueue {
+    public:
+        /**
+         * @brief Appends an event.
+         *
+         * @param event The event.
+         */
+        void push(const CollisionEvent& event) {events.push_back(event);};
+
+        /**
+         * @brief Removes every event, keeping the allocated storage.
+         */
+        void clear() {events.clear();};
+
+        /**
+         * @brief Returns the events in the order they were found.
+         */
+        const std::vector<CollisionEvent>& getEvents() const {return events;};
+
+    private:
+        std::vector<CollisionEvent> events; ///< The events, in the order they were found.
+};
+
+/**
+ * @brief Finds whether the centipede or the spider reached the player, without changing anything.
+ */
+void detectPlayerHits();
+
+/**
+ * @brief Finds what each laser blast hit, without changing anything.
+ */
+void detectBlastHits();
+
+/**
+ * @brief Finds the mushrooms the spider overlaps, without changing anything.
+ */
+void detectSpiderMeals();
+
+/**
+ * @brief Applies the events of every detection pass and empties their queues.
+ *
+ * Player hits are applied first, then blast hits and then spider meals, each
+ * in the order they were found, so the outcome never depends on which
+ * detection pass finished first. An event whose blast or target is gone is
+ * dropped, and its blast flies on to be tested again next tick.
+ */
+void resolveCollisions();
+
+/**
+ * @brief Prints how many events were applied and how many were dropped as stale.
+ */
+void reportCollisionEvents();
+
+#endif
@@ -0,0 +1,332 @@
+#ifndef ENTITIES_H
+#define ENTITIES_H
+
+#include <SFML/Graphics.hpp>
+#include <cstdint>
+#include <vector>
+#include "fixedPoint.h"
+
+using namespace sf;
+
+/**
+ * @struct Entity
+ * @brief Identifies an entity of an EntityStore.
+ *
+ * The index selects the entity's place in the store and the generation must
+ * match the index's current generation for the entity to be live, so an
+ * entity that was destroyed never matches whatever entity later reuses its
+ * index.
+ */
+struct Entity {
+    uint32_t index = UINT32_MAX; ///< The entity index.
+    uint32_t generation = 0; ///< The generation of the index when the entity was created.
+
+    /**
+     * @brief Checks if the entity was ever created.
+     *
+     * @return true if the entity is not the null entity, false otherwise.
+     */
+    bool isNull() const {return index == UINT32_MAX;};
+
+    /**
+     * @brief Checks if two given entities are the same.
+     */
+    bool operator==(const Entity& other) const {return index == other.index && generation == other.generation;};
+
+    /**
+     * @brief Checks if two given entities are different.
+     */
+    bool operator!=(const Entity& other) const {return !(*this == other);};
+};
+
+/**
+ * @struct Placement
+ * @brief Where an entity is on the playfield.
+ */
+struct Placement {
+    FixedVec position; ///< The top left corner, in fixed point.
+};
+
+/**
+ * @struct Collider
+ * @brief The box an entity collides with, anchored at its position.
+ */
+struct Collider {
+    Fixed width; ///< The width of the box.
+    Fixed height; ///< The height of the box.
+
+    /**
+     * @brief Returns the collision box at a position.
+     *
+     * @param placement The entity's placement.
+     * @return FixedRect The collision box.
+     */
+    FixedRect bounds(const Placement& placement) const {
+        return {placement.position.x, placement.position.y, width, height};
+    };
+};
+
+/**
+ * @struct Health
+ * @brief How many hits an entity has left.
+ */
+struct Health {
+    int hitPoints; ///< The hits left, an entity at 0 no longer collides or draws.
+};
+
+/**
+ * @enum Orientation
+ * @brief The direction an entity's texture is turned to face.
+ */
+enum class Orientation {
+    NONE, ///< Not turned, drawn like RIGHT.
+    RIGHT,
+    LEFT,
+    DOWN,
+    UP,
+    COUNT ///< The number of orientations.
+};
+
+/**
+ * @struct Renderable
+ * @brief How an entity is drawn: its texture, unscaled, at its position.
+ */
+struct Renderable {
+    const Texture* texture; ///< The texture drawn, in full.
+    Orientation orientation = Orientation::NONE; ///< The direction the texture is turned to face, over the same box.
+};
+
+/**
+ * @struct Animation
+ * @brief The frames an entity's renderable cycles through on the global animation clock.
+ */
+struct Animation {
+    const std::vector<Texture>* frames; ///< The frame textures, which must not move.
+    uint32_t ticksPerFrame; ///< The number of animation ticks each frame is shown for.
+    uint32_t phase; ///< The animation tick the animation started on.
+};
+
+/**
+ * @struct Motion
+ * @brief The direction an entity's behavior steers it in and how fast it goes.
+ */
+struct Motion {
+    int dx; ///< The horizontal direction, -1, 0 or 1.
+    int dy; ///< The vertical direction, -1, 0 or 1.
+    Fixed speed; ///< The distance covered every tick along a straight direction.
+};
+
+/**
+ * @class ComponentArray
+ * @brief Stores one component per entity in a dense array.
+ *
+ * Components are packed with no gaps, so a system iterating them touches only
+ * that component's memory. A sparse table indexed by entity index finds an
+ * entity's component in O(1). Removal moves the last component into the hole,
+ * so iteration order is insertion order only until the first removal.
+ *
+ * @tparam T The component type.
+ */
+template <typename T>
+class ComponentArray {
+    public:
+        /**
+         * @brief Adds a component to an entity that has none of this type.
+         *
+         * @param entity The entity.
+         * @param value The component.
+         */
+        void insert(Entity entity, const T& value) {
+            if (entity.index >= denseIndex.size()) {
+                denseIndex.resize(entity.index + 1, absent);
+            }
+            denseIndex[entity.index] = static_cast<uint32_t>(values.size());
+            values.push_back(value);
+            entities.push_back(entity);
+        };
+
+        /**
+         * @brief Removes an entity's component, if it has one.
+         *
+         * @param entity The entity.
+         */
+        void remove(Entity entity) {
+            if (!has(entity)) {
+                return;
+            }
+            uint32_t hole = denseIndex[entity.index];
+            uint32_t last = static_cast<uint32_t>(values.size() - 1);
+            if (hole != last) {
+                values[hole] = values[last];
+                entities[hole] = entities[last];
+                denseIndex[entities[hole].index] = hole;
+            }
+            values.pop_back();
+            entities.pop_back();
+            denseIndex[entity.index] = absent;
+        };
+
+        /**
+         * @brief Checks if an entity has a component of this type.
+         *
+         * @param entity The entity.
+         * @return true if the entity is live and has the component, false otherwise.
+         */
+        bool has(Entity entity) const {
+            return entity.index < denseIndex.size() && denseIndex[entity.index] != absent && entities[denseIndex[entity.index]] == entity;
+        };
+
+        /**
+         * @brief Returns an entity's component.
+         *
+         * @param entity The entity.
+         * @return T* The component, or nullptr if the entity has none.
+         */
+        T* get(Entity entity) {
+            return has(entity) ? &values[denseIndex[entity.index]] : nullptr;
+        };
+
+        /**
+         * @brief Returns an entity's component.
+         *
+         * @param entity The entity.
+         * @return const T* The component, or nullptr if the entity has none.
+         */
+        const T* get(Entity entity) const {
+            return has(entity) ? &values[denseIndex[entity.index]] : nullptr;
+        };
+
+        /**
+         * @brief Returns the entity owning the component at a dense index.
+         *
+         * @param i The dense index, below size().
+         */
+        Entity entityAt(size_t i) const {return entities[i];};
+
+        /**
+         * @brief Removes every component, keeping the allocated storage.
+         */
+        void clear() {
+            for (Entity entity : entities) {
+                denseIndex[entity.index] = absent;
+            }
+            values.clear();
+            entities.clear();
+        };
+
+        /**
+         * @brief Returns the number of components.
+         */
+        size_t size() const {return values.size();};
+
+        T& operator[](size_t i) {return values[i];};
+        const T& operator[](size_t i) const {return values[i];};
+        typename std::vector<T>::iterator begin() {return values.begin();};
+        typename std::vector<T>::iterator end() {return values.end();};
+        typename std::vector<T>::const_iterator begin() const {return values.begin();};
+        typename std::vector<T>::const_iterator end() const {return values.end();};
+
+    private:
+        static constexpr uint32_t absent = UINT32_MAX; ///< Marks entity indices without a component.
+
+        std::vector<T> values; ///< The components, packed.
+        std::vector<Entity> entities; ///< The entity owning each component.
+        std::vector<uint32_t> denseIndex; ///< The index in values of each entity index's component, or absent.
+};
+
+/**
+ * @class EntityStore
+ * @brief Creates entities and holds their components, one dense array per component type.
+ *
+ * An entity is only an id, everything known about it lives in the component
+ * arrays, which systems iterate directly. Destroying an entity removes all of
+ * its components. A clear() hands out indices lowest first
+ * again, so entities created after a clear() are numbered in creation order.
+ */
+class EntityStore {
+    public:
+        /**
+         * @brief Creates an entity with no components.
+         *
+         * @return Entity The new entity.
+         */
+        Entity create();
+
+        /**
+         * @brief Destroys an entity and all of its components.
+         *
+         * @param entity The entity.
+         * @return true if the entity was live and has been destroyed, false if it was stale.
+         */
+        bool destroy(Entity entity);
+
+        /**
+         * @brief Checks if an entity is live.
+         *
+         * @param entity The entity.
+         * @return true if the entity was created and not yet destroyed, false otherwise.
+         */
+        bool alive(Entity entity) const {
+            return entity.index < generations.size() && generations[entity.index] == entity.generation && live[entity.index];
+        };
+
+        /**
+         * @brief Returns the live entity with an index.
+         *
+         * @param index The entity index.
+         * @return Entity The entity, or the null entity if no live entity has the index.
+         */
+        Entity entityAt(uint32_t index) const {
+            return (index < live.size() && live[index]) ? Entity{index, generations[index]} : Entity{};
+        };
+
+        /**
+         * @brief Returns the collision box of an entity.
+         *
+         * @param entity The entity, which must have a placement and a collider.
+         * @return FixedRect The collision box.
+         */
+        FixedRect getBounds(Entity entity) const {
+            return colliders.get(entity)->bounds(*placements.get(entity));
+        };
+
+        /**
+         * @brief Destroys every entity, invalidating all of them.
+         */
+        void clear();
+
+        /**
+         * @brief Returns the number of live entities.
+         */
+        size_t size() const {return count;};
+
+        /**
+         * @brief Returns the number of entity indices ever handed out, live or free.
+         */
+        size_t capacity() const {return generations.size();};
+
+        ComponentArray<Placement> placements; ///< Where each entity is.
+        ComponentArray<Collider> colliders; ///< What each entity collides with.
+        ComponentArray<Health> healths; ///< How many hits each entity has left.
+        ComponentArray<Renderable> renderables; ///< How each entity is drawn.
+        ComponentArray<Animation> animations; ///< Which frames each animated entity shows.
+        ComponentArray<Motion> motions; ///< Where each moving entity is heading.
+
+    private:
+        std::vector<uint32_t> generations; ///< The current generation of each entity index.
+        std::vector<uint8_t> live; ///< Whether each entity index is in use.
+        std::vector<uint32_t> freeIndices; ///< Free entity indices, the next one to reuse at the back.
+        size_t count = 0; ///< The number of live entities.
+};
+
+/**
+ * @brief Shows the current frame of every animated entity of a store.
+ *
+ * The animation system: points the renderable of each entity with an
+ * animation at the frame for the current animation tick, see getAnimationFrame().
+ *
+ * @param store The entities.
+ */
+void animateEntities(EntityStore& store);
+
+#endif
@@ -0,0 +1,59 @@
+#ifndef FIELDLAYER_H
+#define FIELDLAYER_H
+
+#include <SFML/Graphics.hpp>
+#include "globals.h"
+
+using namespace sf;
+
+/**
+ * @struct FieldLayerStats
+ * @brief Counts how the cached background and mushroom layer was produced each frame.
+ */
+struct FieldLayerStats {
+    long hits; ///< Frames drawn straight from the cache.
+    long patches; ///< Frames that repainted only the changed cells.
+    long rebuilds; ///< Frames that recomposited the whole layer.
+};
+
+/**
+ * @brief Creates the render texture, or the CPU framebuffer in software rendering, that caches the background and mushroom field.
+ *
+ * @param background The full-screen background sprite composited under the mushrooms.
+ */
+void fieldLayerInit(const Sprite& background);
+
+/**
+ * @brief Marks the whole cached layer stale so it is recomposited on the next draw.
+ *
+ * Used when the mushroom field is regenerated or cleared, or the textures change color.
+ */
+void invalidateFieldLayer();
+
+/**
+ * @brief Marks an area of the cached layer stale so only it is repainted on the next draw.
+ *
+ * Used when a single mushroom is hit, spawned or eaten.
+ *
+ * @param area The area of the playfield that changed.
+ */
+void patchFieldLayer(const FloatRect& area);
+
+/**
+ * @brief Brings the cached layer up to date and draws it as a single quad, or a single copy in software rendering.
+ */
+void drawFieldLayer();
+
+/**
+ * @brief Returns the cache hit, patch and rebuild counters.
+ *
+ * @return FieldLayerStats The counters since startup.
+ */
+const FieldLayerStats& getFieldLayerStats();
+
+/**
+ * @brief Prints the cache hit, patch and rebuild counters.
+ */
+void reportFieldLayerStats();
+
+#endif
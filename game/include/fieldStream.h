@@ -0,0 +1,54 @@
+#ifndef FIELDSTREAM_H
+#define FIELDSTREAM_H
+
+#include <cstdint>
+
+/**
+ * @brief Reads the endless mode options from the command line.
+ *
+ * Recognizes --endless, optionally followed by the number of ticks the field
+ * takes to scroll one row.
+ *
+ * @param argc The argument count from main.
+ * @param argv The arguments from main.
+ */
+void parseFieldStreamArgs(int argc, char* argv[]);
+
+/**
+ * @brief Checks if the game runs in endless mode.
+ *
+ * @return true if the field scrolls endlessly, false for the fixed field.
+ */
+bool isEndless();
+
+/**
+ * @brief Starts a new endless field from a seed, filling the screen.
+ *
+ * The endless field is an unbounded column of mushroom rows. It is generated
+ * chunkRows rows at a time, each chunk from the seed and its own index, so a
+ * seed always gives the same field however far it is played. Only the rows on
+ * screen exist as mushrooms, plus one buffered chunk of health bytes waiting
+ * above the screen, so memory and collision structures stay the size of the
+ * screen however far the field has scrolled.
+ *
+ * @param seed The seed.
+ */
+void resetFieldStream(uint32_t seed);
+
+/**
+ * @brief Advances the endless field by one tick.
+ *
+ * Every ticksPerRow ticks the mushrooms move down one row. Rows reaching the
+ * bottom border are dropped, mushrooms scrolled onto the player or the
+ * centipede are crushed and the next row enters at the top.
+ */
+void scrollFieldStream();
+
+/**
+ * @brief Returns how many rows the endless field has scrolled since it was reset.
+ *
+ * @return uint64_t The number of rows scrolled.
+ */
+uint64_t getScrolledRows();
+
+#endif
@@ -0,0 +1,119 @@
+#ifndef FIXEDPOINT_H
+#define FIXEDPOINT_H
+
+#include <SFML/Graphics.hpp>
+#include <cmath>
+#include <cstdint>
+
+using namespace sf;
+
+/**
+ * @brief A playfield coordinate in 16.16 fixed point: 1/65536 of a pixel per unit.
+ *
+ * The simulation runs entirely on integer fixed-point coordinates, so every
+ * move and collision is exact and a game replays bit for bit regardless of
+ * compiler, optimization level or floating-point mode. Floats only appear when
+ * positions are handed to SFML for drawing.
+ */
+using Fixed = int32_t;
+
+const int FIXED_SHIFT = 16; ///< The number of fractional bits.
+const Fixed FIXED_ONE = 1 << FIXED_SHIFT; ///< One pixel.
+const Fixed FIXED_INV_SQRT2 = 46341; ///< 1 / sqrt(2), rounded, for normalizing diagonal steps.
+const int FIXED_MAX_PIXELS = INT32_MAX >> FIXED_SHIFT; ///< The largest number of whole pixels toFixed() can convert.
+
+/**
+ * @brief Converts whole pixels to fixed point.
+ *
+ * @param pixels The number of pixels.
+ * @return Fixed The same distance in fixed point.
+ */
+constexpr Fixed toFixed(int pixels) {return pixels * FIXED_ONE;}
+
+/**
+ * @brief Converts fixed point to whole pixels, rounding towards negative infinity.
+ *
+ * @param value The fixed-point value.
+ * @return int The number of whole pixels.
+ */
+constexpr int toPixels(Fixed value) {return (value >= 0) ? value / FIXED_ONE : -((-value + FIXED_ONE - 1) / FIXED_ONE);}
+
+/**
+ * @brief Converts fixed point to a float for drawing.
+ *
+ * @param value The fixed-point value.
+ * @return float The value in pixels.
+ */
+inline float toFloat(Fixed value) {return static_cast<float>(value) / FIXED_ONE;}
+
+/**
+ * @brief Converts a float to the nearest fixed-point value.
+ *
+ * Only for values entering the simulation from outside it, such as tuning constants.
+ *
+ * @param value The value in pixels.
+ * @return Fixed The nearest fixed-point value.
+ */
+inline Fixed fromFloat(float value) {return static_cast<Fixed>(std::lround(value * FIXED_ONE));}
+
+/**
+ * @brief Multiplies two fixed-point values.
+ *
+ * @param a The first value.
+ * @param b The second value.
+ * @return Fixed The product, rounded towards negative infinity.
+ */
+constexpr Fixed fixedMul(Fixed a, Fixed b) {return static_cast<Fixed>((static_cast<int64_t>(a) * b) >> FIXED_SHIFT);}
+
+/**
+ * @brief Returns the sign of a fixed-point value.
+ *
+ * @param value The value.
+ * @return int 1 if positive, -1 if negative, 0 if zero.
+ */
+constexpr int getSign(Fixed value) {return (value > 0) - (value < 0);}
+
+/**
+ * @struct FixedVec
+ * @brief A playfield position or offset in fixed point.
+ */
+struct FixedVec {
+    Fixed x = 0; ///< The horizontal component.
+    Fixed y = 0; ///< The vertical component.
+
+    /**
+     * @brief Converts the vector to floats for drawing.
+     */
+    Vector2f toFloat() const {return Vector2f(::toFloat(x), ::toFloat(y));};
+
+    bool operator==(const FixedVec& other) const {return x == other.x && y == other.y;};
+    bool operator!=(const FixedVec& other) const {return !(*this == other);};
+};
+
+/**
+ * @struct FixedRect
+ * @brief An axis-aligned playfield box in fixed point.
+ */
+struct FixedRect {
+    Fixed left = 0; ///< The left edge.
+    Fixed top = 0; ///< The top edge.
+    Fixed width = 0; ///< The width, positive.
+    Fixed height = 0; ///< The height, positive.
+
+    /**
+     * @brief Checks if two boxes overlap, boxes only touching along an edge do not.
+     *
+     * @param other The other box.
+     * @return true if the boxes overlap, false otherwise.
+     */
+    bool intersects(const FixedRect& other) const {
+        return left < other.left + other.width && other.left < left + width && top < other.top + other.height && other.top < top + height;
+    };
+
+    /**
+     * @brief Converts the box to floats for drawing.
+     */
+    FloatRect toFloat() const {return FloatRect(::toFloat(left), ::toFloat(top), ::toFloat(width), ::toFloat(height));};
+};
+
+#endif
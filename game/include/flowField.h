@@ -0,0 +1,72 @@
+#ifndef FLOWFIELD_H
+#define FLOWFIELD_H
+
+#include <cstdint>
+#include <vector>
+#include "boxArray.h"
+#include "fixedPoint.h"
+
+/**
+ * @class FlowField
+ * @brief Distances to the player row over the mushroom grid, with each cell's vertical step towards it.
+ *
+ * A breadth first search from the open cells of the player row, moving
+ * between neighbouring cells that no mushroom overlaps, gives every cell its
+ * distance to the row. Each cell then stores the vertical step a head moving
+ * horizontally in either direction should take, so steering a head is one
+ * table lookup however many heads there are. The field is only recomputed
+ * when the mushroom boxes, the player row or the grid changed, and keeps its
+ * storage between recomputations.
+ */
+class FlowField {
+    public:
+        /**
+         * @brief Recomputes the field if anything it was computed from changed.
+         *
+         * An empty grid leaves the field without preferences until a later update has cells.
+         *
+         * @param columns The number of grid columns.
+         * @param rows The number of grid rows.
+         * @param cell The cell size.
+         * @param targetRow The row the player is in, clamped to the grid.
+         * @param mushroomBoxes The mushroom boxes.
+         * @param version The version of the mushroom boxes, see getMushroomBoxesVersion().
+         */
+        void update(int columns, int rows, Fixed cell, int targetRow, const BoxArray& mushroomBoxes, uint32_t version);
+
+        /**
+         * @brief Returns the vertical step bringing a head closer to the player row.
+         *
+         * @param position The top left corner of the head.
+         * @param dx The horizontal direction of the head.
+         * @return int -1 or 1, or 0 when neither step is closer or the cell cannot reach the row.
+         */
+        int verticalStep(const FixedVec& position, int dx) const;
+
+        /**
+         * @brief Returns the number of times the field was recomputed.
+         */
+        uint64_t getRebuilds() const {return rebuilds;};
+
+    private:
+        /**
+         * @brief Returns the distance of a cell to the target row, or unreachable outside the grid.
+         */
+        uint32_t distanceAt(int column, int row) const;
+
+        static constexpr uint32_t unreachable = UINT32_MAX; ///< The distance of cells cut off from the target row.
+
+        int columns = 0; ///< The number of grid columns.
+        int rows = 0; ///< The number of grid rows.
+        Fixed cell = 0; ///< The cell size.
+        int targetRow = -1; ///< The row the field leads to.
+        uint32_t version = 0; ///< The version of the mushroom boxes the field was computed from.
+        bool computed = false; ///< Whether the field was computed at least once.
+        std::vector<uint8_t> blocked; ///< Per cell, whether a mushroom overlaps it.
+        std::vector<uint32_t> distances; ///< Per cell, the number of moves to the target row.
+        std::vector<int8_t> steps; ///< Per cell, the vertical step when moving left, then when moving right.
+        std::vector<uint32_t> frontier; ///< The search queue, cell indices.
+        uint64_t rebuilds = 0; ///< The number of times the field was recomputed.
+};
+
+#endif
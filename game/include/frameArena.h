@@ -0,0 +1,40 @@
+#ifndef FRAMEARENA_H
+#define FRAMEARENA_H
+
+#include <memory_resource>
+
+/**
+ * @brief Returns the monotonic arena for temporaries that live no longer than a frame.
+ *
+ * Allocations from the arena are a pointer bump into a fixed buffer and are
+ * released in bulk by frameArenaReset(). Containers drawing from it should be
+ * std::pmr containers constructed with this resource.
+ *
+ * @return std::pmr::memory_resource* The frame arena.
+ */
+std::pmr::memory_resource* frameArena();
+
+/**
+ * @brief Releases everything allocated from the frame arena.
+ *
+ * Must only be called at the end of a frame, once no arena-backed container is alive.
+ */
+void frameArenaReset();
+
+/**
+ * @brief Records whether a steady-state frame touched the general heap.
+ *
+ * With CENTIPEDE_ASSERT_NO_FRAME_ALLOCS defined, a steady-state frame that made
+ * any general-heap allocation fails an assertion.
+ *
+ * @param allocationsBefore The value of getHeapAllocationCount() from memoryTracker.h at the start of the frame.
+ * @param steadyState Whether the frame had no score, life or wave change.
+ */
+void checkFrameAllocations(long allocationsBefore, bool steadyState);
+
+/**
+ * @brief Prints the arena overflow and steady-state allocation counters.
+ */
+void reportFrameAllocations();
+
+#endif
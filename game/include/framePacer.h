@@ -0,0 +1,69 @@
+#ifndef FRAMEPACER_H
+#define FRAMEPACER_H
+
+#include <chrono>
+#include <cstdint>
+#include <vector>
+
+/**
+ * @class FramePacer
+ * @brief Paces frames to a fixed target time using a coarse sleep followed by a spin.
+ *
+ * OS sleeps routinely overshoot by a millisecond or more, so the pacer only sleeps
+ * until shortly before the frame deadline and spins for the remainder. Deadlines
+ * advance by exactly one target frame time, so an early or late frame does not
+ * shift every frame after it.
+ */
+class FramePacer {
+    public:
+        /**
+         * @brief Constructs a FramePacer for a given target frame time.
+         *
+         * @param targetFrameTime The target time per frame in seconds.
+         * @param spinTime The time before the deadline at which to stop sleeping and start spinning, in seconds.
+         */
+        FramePacer(double targetFrameTime, double spinTime = 0.002);
+
+        /**
+         * @brief Waits until the current frame's deadline and records its timing.
+         *
+         * Should be called right after the frame has been presented.
+         */
+        void wait();
+
+        /**
+         * @brief Prints the p50, p99 and max frame time and deadline jitter.
+         */
+        void report() const;
+
+    private:
+        using SteadyClock = std::chrono::steady_clock;
+
+        /**
+         * @brief Adds a sample to a histogram of 10 microsecond buckets.
+         *
+         * @param histogram The histogram to add to.
+         * @param micros The sample in microseconds.
+         */
+        static void record(std::vector<uint32_t>& histogram, long micros);
+
+        /**
+         * @brief Returns the given percentile of a histogram in milliseconds.
+         *
+         * @param histogram The histogram to read.
+         * @param percentile The percentile between 0 and 1.
+         * @return double The upper bound of the bucket holding the percentile.
+         */
+        static double percentile(const std::vector<uint32_t>& histogram, double percentile);
+
+        SteadyClock::duration targetFrameTime; ///< The target time per frame.
+        SteadyClock::duration spinTime; ///< The time spent spinning before each deadline.
+        SteadyClock::time_point deadline; ///< The time the current frame should end.
+        SteadyClock::time_point lastFrame; ///< The time the previous frame ended.
+        std::vector<uint32_t> frameTimes; ///< Histogram of frame times.
+        std::vector<uint32_t> jitters; ///< Histogram of how late each frame woke after its deadline.
+        long maxFrameTime, maxJitter; ///< The largest frame time and jitter in microseconds.
+        long frameCount; ///< The number of frames recorded.
+};
+
+#endif
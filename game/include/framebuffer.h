@@ -0,0 +1,197 @@
+#ifndef FRAMEBUFFER_H
+#define FRAMEBUFFER_H
+
+#include <SFML/Graphics.hpp>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+using namespace sf;
+
+/**
+ * @class Framebuffer
+ * @brief A frame rasterized on the CPU, for rendering without a window or GPU draw calls.
+ *
+ * Pixels are 32-bit RGBA in the same byte order as sf::Image. Sprites and text
+ * are drawn as textured quads under their full transform, so the rotations and
+ * mirrorings applied by the centipede's orientations come out exactly as on the
+ * window, sampled nearest-neighbour. Each covered row is fetched from the
+ * texture into a span and then alpha blended onto the frame 4 pixels at a time
+ * with SSE2, falling back to a scalar loop elsewhere.
+ *
+ * The frame never touches the GPU. Sprites are drawn from the pixels given
+ * to setTextureImage(), keyed on the sf::Texture the sprite points at, which
+ * the software backend never uploads, see loadTexture(). Text is drawn from
+ * glyph atlases FreeType rasterized for prepareGlyphs() when the game is built
+ * with it, so no OpenGL context is needed.
+ */
+class Framebuffer {
+    public:
+        /**
+         * @brief Allocates the frame and clears it to black.
+         *
+         * @param width The width in pixels.
+         * @param height The height in pixels.
+         */
+        void create(unsigned width, unsigned height);
+
+        /**
+         * @brief Fills the whole frame with one color, ignoring the clip area.
+         *
+         * @param color The color to fill with.
+         */
+        void clear(const Color& color = Color::Black);
+
+        /**
+         * @brief Restricts drawing to an area of the frame.
+         *
+         * @param area The area in pixels, rounded outwards to whole pixels.
+         */
+        void setClip(const FloatRect& area);
+
+        /**
+         * @brief Lets drawing cover the whole frame again.
+         */
+        void resetClip();
+
+        /**
+         * @brief Blends a sprite onto the frame.
+         *
+         * @param sprite The sprite, drawn with its texture rect, transform and color.
+         */
+        void draw(const Sprite& sprite);
+
+        /**
+         * @brief Blends a whole texture onto the frame.
+         *
+         * @param texture The texture.
+         * @param transform Maps the texture's pixels onto the frame.
+         */
+        void draw(const Texture& texture, const Transform& transform);
+
+        /**
+         * @brief Blends a single line of text onto the frame.
+         *
+         * The font's glyphs must already be in its texture, see prepareGlyphs().
+         *
+         * @param text The text, drawn with its font, character size, transform and fill color.
+         */
+        void draw(const Text& text);
+
+        /**
+         * @brief Copies another frame of the same size over this one, within the clip area.
+         *
+         * @param layer The frame to copy, treated as opaque.
+         */
+        void draw(const Framebuffer& layer);
+
+        /**
+         * @brief Writes the frame as a binary PPM image.
+         *
+         * @param path The file to write.
+         * @return true if the file was written, false otherwise.
+         */
+        bool saveToFile(const std::string& path) const;
+
+        /**
+         * @brief Returns a hash of every pixel, for comparing frames.
+         *
+         * @return uint64_t The FNV-1a hash of the pixels.
+         */
+        uint64_t hash() const;
+
+        /**
+         * @brief Returns the width in pixels.
+         */
+        unsigned getWidth() const {return width;};
+
+        /**
+         * @brief Returns the height in pixels.
+         */
+        unsigned getHeight() const {return height;};
+
+        /**
+         * @brief Returns the pixels, row by row.
+         */
+        const uint32_t* getPixels() const {return pixels.data();};
+
+    private:
+        /**
+         * @brief Blends the part of a texture rect mapped through a transform onto the frame.
+         *
+         * @param image The texture pixels to sample.
+         * @param textureRect The texels covered, a negative width or height mirrors them.
+         * @param transform Maps the quad (0, 0) to (|width|, |height|) onto the frame.
+         * @param color The color the texels are multiplied by.
+         */
+        void drawQuad(const Image& image, const IntRect& textureRect, const Transform& transform, const Color& color);
+
+        unsigned width = 0; ///< The width in pixels.
+        unsigned height = 0; ///< The height in pixels.
+        IntRect clip; ///< The area drawing is restricted to.
+        std::vector<uint32_t> pixels; ///< The pixels, row by row.
+        std::vector<uint32_t> span; ///< The texels fetched for the row being drawn.
+};
+
+/**
+ * @brief Sets the pixels sprites showing a texture are drawn with.
+ *
+ * @param texture The texture, identified by its address, so it must not move while in use.
+ * @param image The pixels.
+ */
+void setTextureImage(const Texture& texture, const Image& image);
+
+/**
+ * @brief Replaces the pixels of a texture set with setTextureImage(), keeping its size.
+ *
+ * @param texture The texture.
+ * @param pixels The RGBA pixels, as many as the image already holds.
+ */
+void updateTextureImage(const Texture& texture, const Uint8* pixels);
+
+/**
+ * @brief Returns the pixels set for a texture.
+ *
+ * @param texture The texture.
+ * @return const Image* The pixels, or null if none were set.
+ */
+const Image* findTextureImage(const Texture& texture);
+
+/**
+ * @brief Opens a font file with FreeType so prepareGlyphs() can rasterize it on the CPU.
+ *
+ * @param font The font texts will name, identified by its address.
+ * @param path The font file the font was loaded from.
+ * @return true if FreeType opened the file, false otherwise or if the game was built without FreeType.
+ */
+bool loadGlyphFont(const Font& font, const std::string& path);
+
+/**
+ * @brief Makes every printable ASCII glyph of a font at a size ready for drawing.
+ *
+ * Builds a glyph atlas with FreeType if loadGlyphFont() opened the font.
+ * Otherwise loads the glyphs into the font's own page and reads it back from
+ * SFML, which needs an OpenGL context. Either way all glyphs a text may show
+ * must be prepared before the first draw.
+ *
+ * @param font The font.
+ * @param characterSize The character size in pixels.
+ */
+void prepareGlyphs(const Font& font, unsigned characterSize);
+
+/**
+ * @brief Returns the box sf::Text::getLocalBounds() would, from the glyphs prepareGlyphs() made ready.
+ *
+ * @param text The text.
+ * @return FloatRect The box around the laid out glyphs.
+ */
+FloatRect measureText(const Text& text);
+
+/**
+ * @brief Selects the span blending kernel, for comparing it against the scalar loop.
+ *
+ * @param simd true to blend with SSE2 where available, false for the scalar loop.
+ */
+void setSimdSpans(bool simd);
+
+#endif
@@ -6,7 +6,6 @@
 using namespace sf;
 
 extern RenderWindow window;
-extern int globalCounter;
 extern int windowWidth, windowHeight;
 
 enum class Screen {
@@ -0,0 +1,52 @@
+#ifndef INPUT_H
+#define INPUT_H
+
+#include <chrono>
+#include <cstdint>
+#include "globals.h"
+
+/**
+ * @brief Bit flags for the keys sampled by the input thread.
+ */
+enum InputKey : uint8_t {
+    KEY_LEFT = 1 << 0,
+    KEY_RIGHT = 1 << 1,
+    KEY_UP = 1 << 2,
+    KEY_DOWN = 1 << 3,
+    KEY_FIRE = 1 << 4,
+    KEY_START = 1 << 5
+};
+
+/**
+ * @struct InputEvent
+ * @brief A change in the sampled key state and the time it was observed.
+ */
+struct InputEvent {
+    uint8_t keys; ///< The InputKey flags held when the change was sampled.
+    std::chrono::steady_clock::time_point timestamp; ///< The time the change was sampled.
+};
+
+/**
+ * @brief Starts the input thread, which samples the keyboard at 1 kHz.
+ *
+ * Key state changes are pushed as timestamped events into a lock-free
+ * single-producer single-consumer queue drained by latchInputs().
+ */
+void inputInit();
+
+/**
+ * @brief Stops the input thread and prints the input latency histogram.
+ */
+void inputShutdown();
+
+/**
+ * @brief Drains all pending input events and returns the latest key state.
+ *
+ * Should be called as late as possible in the tick, right before the state is
+ * acted upon. The time each event spent waiting is recorded as its latency.
+ *
+ * @return uint8_t The InputKey flags currently held.
+ */
+uint8_t latchInputs();
+
+#endif
@@ -6,84 +6,108 @@
 #include "centipede.h"
 #include "spider.h"
 #include "mushroom.h"
-#include <list>
+#include "entities.h"
+#include "spriteBatch.h"
+#include "timerWheel.h"
+#include "collisionEvents.h"
 
 using namespace sf;
 
 /**
- * @class ECE_LaserBlast
- * @brief Represents a laser blast in the game.
+ * @class ECE_LaserBlaster
+ * @brief Represents a laser blaster in the game.
  * 
- * This class inherits from the Sprite class and provides functionality
- * for a laser blast, including movement and collision handling.
+ * The ECE_LaserBlaster class provides functionalities for updating the blaster's state,
+ * shooting laser blasts, managing scores and lives, and drawing the blaster on the screen.
+ * The ship and its laser blasts are entities with a Placement, a Collider the size
+ * of their texture and a Renderable, the blasts kept in a store of their own.
+ * Only the blasts have a Motion, which the blast systems iterate.
  */
-class ECE_LaserBlast : public Sprite {
+class ECE_LaserBlaster {
     public:
         /**
-         * @brief Constructs an ECE_LaserBlast object with a specified blast speed.
+         * @brief Constructs a new ECE_LaserBlaster object with a specified speed, blast speed, and reload time.
          * 
-         * @param blastSpeed The speed at which the laser blast travels.
+         * @param speed The speed of the laser blaster.
+         * @param blastSpeed The speed of the laser blasts.
+         * @param reloadTime The game time in seconds between shots.
          */
-        ECE_LaserBlast(float blastSpeed);
+        ECE_LaserBlaster(float speed, float blastSpeed, float reloadTime);
 
         /**
-         * @brief Moves the laser blast.
-         * @return True if the laser blast is still on the screen, false otherwise.
+         * @brief Moves the laser blaster in the given direction unless a mushroom is in the way.
+         * 
+         * @param direction The direction to move the laser blaster.
          */
-        bool move();
+        void update(Direction direction);
 
         /**
-         * @brief Handles collision detection for the laser blast.
-         * @return True if a collision occurred and laser blast should be removed, false otherwise.
+         * @brief Reports a player hit if the centipede or spider has reached the player.
+         *
+         * @param events Receives the event.
          */
-        bool handleCollision();
+        void detectPlayerHit(CollisionQueue& events);
 
         /**
-         * @brief Check if two given laser blasts are the same.
-         * @return The ID of the other laser blast.
+         * @brief Reports what every laser blast hits.
+         *
+         * Tests mushrooms, then the centipede, then the spider, reporting only the
+         * first thing each blast hits.
+         *
+         * @param events Receives one event per blast that hit something, in the order of the blast motions.
          */
-        bool operator==(const ECE_LaserBlast& other) const {return id == other.id;};
-    private:
-        float speed; ///< The speed of the laser blast.
-        int id; ///< The ID of the laser blast.
-};
+        void detectBlastHits(CollisionQueue& events);
 
-/**
- * @class ECE_LaserBlaster
- * @brief Represents a laser blaster in the game, inheriting from the Sprite class.
- * 
- * The ECE_LaserBlaster class provides functionalities for updating the blaster's state,
- * shooting laser blasts, managing scores and lives, and drawing the blaster on the screen.
- */
-class ECE_LaserBlaster : public Sprite {
-    public:
         /**
-         * @brief Constructs a new ECE_LaserBlaster object with a specified speed, blast speed, and reload time.
+         * @brief Costs the player a life, restarting the centipede and moving the player back to the start.
+         */
+        void loseLife();
+
+        /**
+         * @brief Moves the laser blasts, removing the ones that left the screen.
+         */
+        void moveBlasts();
+
+        /**
+         * @brief Shoots a laser blast from the position of the player unless the blaster is still reloading.
+         */
+        void shoot();
+
+        /**
+         * @brief Checks if a laser blast is still active.
          * 
-         * @param speed The speed of the laser blaster.
-         * @param blastSpeed The speed of the laser blasts.
-         * @param reloadTime The time between shots.
+         * @param blast The blast.
+         * @return true if the blast has not left the screen or hit anything yet, false otherwise.
          */
-        ECE_LaserBlaster(float speed, float blastSpeed, float reloadTime);
+        bool hasBlast(Entity blast) const {return blasts.motions.has(blast);};
 
         /**
-         * @brief Updates the state of the laser blaster based on the given direction.
+         * @brief Removes a laser blast that hit something.
          * 
-         * @param direction The direction to move the laser blaster.
+         * @param blast The active blast.
          */
-        void update(Direction direction);
+        void removeBlast(Entity blast) {blasts.destroy(blast);};
+
+        /**
+         * @brief Returns the number of active laser blasts.
+         * 
+         * @return size_t The number of blasts.
+         */
+        size_t getBlastCount() const {return blasts.motions.size();};
 
         /**
-         * @brief Shoots a laser blast from the position of the player.
+         * @brief Returns the position of the ship.
+         * 
+         * @return FixedVec The top left corner of the ship.
          */
-        void shoot();
+        FixedVec getFixedPosition() const {return entities.placements.get(ship)->position;};
 
         /**
-         * @brief Returns the list of laser blasts.
+         * @brief Returns the collision box of the ship.
          * 
-         * @return std::list<ECE_LaserBlast> The list of laser blasts.
+         * @return FixedRect The collision box.
          */
-        std::list<ECE_LaserBlast>& getBlasts() {return blasts;};
+        FixedRect getFixedBounds() const {return entities.getBounds(ship);};
 
         /**
          * @brief Resets the score, lives, and laser blaster to their initial states.
@@ -151,10 +175,14 @@ class ECE_LaserBlaster : public Sprite {
         void resetPosition();
 
     private:
-        std::list<ECE_LaserBlast> blasts; ///< The list of laser blasts.
-        float speed, blastSpeed, shotDelay; ///< The speed of the laser blaster, the speed of the laser blasts, and the time between shots.
+        EntityStore entities; ///< Holds the ship.
+        Entity ship; ///< The ship.
+        EntityStore blasts; ///< The active laser blasts, so removing one never moves the ship's components.
+        SpriteBatch batch; ///< The ship and blast quads of the frame being drawn.
+        Fixed speed, blastSpeed; ///< The speed of the laser blaster and the speed of the laser blasts.
+        uint32_t reloadTicks; ///< The number of game ticks between shots.
         int lives, score, highScore; ///< The number of lives, the current score, and the high score.
-        Clock shotClock; ///< The clock to keep track of the time between shots.
+        Timer reloadTimer; ///< Pending while the blaster reloads after a shot.
 };
 
 /**
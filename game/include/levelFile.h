@@ -0,0 +1,129 @@
+#ifndef LEVELFILE_H
+#define LEVELFILE_H
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+/**
+ * @struct LevelHeader
+ * @brief The header at the start of a level file.
+ *
+ * A level file is this header followed by one health byte per grid cell, row
+ * by row, 0 for an empty cell. Cell (column, row) has its mushroom at
+ * (column * cellWidth, row * cellHeight). All fields are little-endian.
+ */
+struct LevelHeader {
+    char magic[4]; ///< Always "CPLV".
+    uint32_t version; ///< The format version, currently 1.
+    uint32_t columns; ///< The number of grid columns.
+    uint32_t rows; ///< The number of grid rows.
+    uint32_t cellWidth; ///< The width of a cell in pixels.
+    uint32_t cellHeight; ///< The height of a cell in pixels.
+};
+
+/**
+ * @class LevelFile
+ * @brief A read-only level file, memory-mapped where the platform allows it.
+ *
+ * Mapping reads only the pages that are touched and lets parallel runs of
+ * the same level share them in the page cache. Elsewhere the file is read
+ * into memory instead. The file stays open until close() or destruction, so
+ * the same level can be applied again for every new game without touching
+ * the disk.
+ */
+class LevelFile {
+    public:
+        LevelFile() = default;
+        LevelFile(const LevelFile&) = delete;
+        LevelFile& operator=(const LevelFile&) = delete;
+        ~LevelFile() {close();};
+
+        /**
+         * @brief Opens and validates a level file, closing any file already open.
+         *
+         * Rejects levels whose grid spans more pixels than fixed point holds.
+         *
+         * @param path The path of the file.
+         * @return true if the file is a valid level, false otherwise.
+         */
+        bool open(const char* path);
+
+        /**
+         * @brief Releases the mapping or buffer.
+         */
+        void close();
+
+        /**
+         * @brief Checks if a valid level is open.
+         *
+         * @return true if a level is open, false otherwise.
+         */
+        bool isOpen() const {return data != nullptr;};
+
+        /**
+         * @brief Returns the header of the open level.
+         *
+         * @return const LevelHeader& The header.
+         */
+        const LevelHeader& getHeader() const {return header;};
+
+        /**
+         * @brief Returns the health bytes of the open level, row by row.
+         *
+         * @return const uint8_t* The columns * rows health bytes.
+         */
+        const uint8_t* getCells() const {return data + sizeof(LevelHeader);};
+
+        /**
+         * @brief Replaces the mushroom field with the open level.
+         *
+         * Cells that do not fit entirely inside the window are left out.
+         */
+        void apply() const;
+
+    private:
+        LevelHeader header = {}; ///< A copy of the header.
+        const uint8_t* data = nullptr; ///< The start of the file contents.
+        size_t size = 0; ///< The size of the file contents.
+        bool mapped = false; ///< Whether data is a memory mapping rather than buffer.
+        std::vector<uint8_t> buffer; ///< The file contents where mapping is unavailable.
+};
+
+/**
+ * @brief Writes the current mushroom field as a level file.
+ *
+ * The grid uses the mushroom texture size as its cell size and covers the
+ * window. A mushroom snaps to the cell its center is in, and when two share
+ * a cell the healthier one is kept.
+ *
+ * @param path The path of the file.
+ * @return true if the file was written, false otherwise.
+ */
+bool saveLevel(const char* path);
+
+/**
+ * @brief Reads the level options from the command line.
+ *
+ * Recognizes --level followed by a level file to play instead of generated
+ * mushroom fields and --save-level followed by a file to snapshot the field
+ * to on exit.
+ *
+ * @param argc The argument count from main.
+ * @param argv The arguments from main.
+ */
+void parseLevelArgs(int argc, char* argv[]);
+
+/**
+ * @brief Applies the level given with --level, if any.
+ *
+ * @return true if a level replaced the mushroom field, false if none was given.
+ */
+bool applyConfiguredLevel();
+
+/**
+ * @brief Snapshots the mushroom field to the file given with --save-level, if any.
+ */
+void saveConfiguredLevel();
+
+#endif
@@ -0,0 +1,69 @@
+#ifndef MEMORYTRACKER_H
+#define MEMORYTRACKER_H
+
+#include <cstdint>
+
+/**
+ * @brief The subsystems general-heap allocations are attributed to.
+ */
+enum class Subsystem : uint8_t {
+    OTHER,
+    CENTIPEDE,
+    MUSHROOM,
+    LASER,
+    SPIDER,
+    HUD,
+    TEXTURES,
+    COUNT
+};
+
+/**
+ * @class MemoryScope
+ * @brief Attributes general-heap allocations made on this thread to a subsystem while in scope.
+ *
+ * Scopes nest, restoring the enclosing subsystem when they end. Without
+ * CENTIPEDE_MEMORY_TRACKING the scope compiles away entirely.
+ */
+class MemoryScope {
+    public:
+#ifdef CENTIPEDE_MEMORY_TRACKING
+        /**
+         * @brief Starts attributing allocations to a subsystem.
+         *
+         * @param subsystem The subsystem to attribute allocations to.
+         */
+        explicit MemoryScope(Subsystem subsystem);
+
+        /**
+         * @brief Restores the enclosing subsystem.
+         */
+        ~MemoryScope();
+
+    private:
+        Subsystem previous; ///< The subsystem active before this scope.
+#else
+        explicit MemoryScope(Subsystem) {};
+#endif
+};
+
+/**
+ * @brief Returns the number of general-heap allocations made since startup.
+ *
+ * @return long The number of calls to the global operator new.
+ */
+long getHeapAllocationCount();
+
+/**
+ * @brief Closes the current frame's allocation statistics and checks for unbounded growth.
+ *
+ * Live bytes per subsystem are sampled periodically, and a subsystem whose live
+ * bytes keep rising across every sample in the window is flagged once.
+ */
+void memoryFrameEnd();
+
+/**
+ * @brief Prints per-subsystem allocation counts, bytes and high-water marks.
+ */
+void reportMemoryUsage();
+
+#endif
@@ -2,77 +2,158 @@
 #define MUSHROOM_H
 
 #include <SFML/Graphics.hpp>
-#include <list>
+#include <memory_resource>
+#include <random>
+#include "boxArray.h"
+#include "entities.h"
 
 using namespace sf;
 
-/**
- * @class Mushroom
- * @brief Represents a mushroom in the game, inheriting from the Sprite class.
- * 
- * The Mushroom class provides functionality to handle collisions, manage health,
- * and compare mushrooms based on their unique identifiers.
- */
-class Mushroom : public Sprite {
-    public:
-        /**
-         * @brief Default constructor for the Mushroom class.
-         * 
-         * This constructor initializes a new instance of the Mushroom class.
-         */
-        Mushroom();
-        
-        /**
-         * @brief Handles mushroom collision with laser blasts.
-         */
-        void handleCollision();
-
-        /**
-         * @brief Gets the health of the mushroom.
-         * @return The health of the mushroom.
-         */
-        int getHealth() {return health;};
-
-        /**
-         * @brief Sets the health of the mushroom.
-         * @param health The new health value.
-         */
-        void setHealth(int health) {this->health = health;};
-
-        /**
-         * @brief Checks if two given mushrooms are the same.
-         * @return The ID of the other mushroom.
-         */
-        bool operator==(const Mushroom& other) const {return id == other.id;};
-        
-    private:
-        int health; ///< The health of the mushroom.
-        int id; ///< The ID of the mushroom.
-};
-
 /**
  * @brief Texture initialization for mushrooms.
  */
 void mushroomInit();
 
+const int mushroomsPerField = 30; ///< The number of mushrooms in a generated field.
+
 /**
- * @brief Generates mushrooms at random positions.
+ * @brief How generateMushrooms() spreads mushrooms over the field's grid cells.
+ */
+enum class MushroomLayout {
+    UNIFORM, ///< Every cell is equally likely.
+    BLUE_NOISE ///< Cells are picked from a Poisson-disk set, so mushrooms never crowd together.
+};
+
+/**
+ * @brief Replaces the mushrooms with a fresh random field.
+ *
+ * Plays the level given with --level if there is one, see levelFile.h.
+ * Otherwise uses the seed and layout set by parseMushroomArgs(), starting an
+ * endless field instead in endless mode, see fieldStream.h. With a seed, every call
+ * uses the next seed in sequence so a run of games is reproducible, otherwise
+ * each field is seeded from std::random_device.
  */
 void generateMushrooms();
 
+/**
+ * @brief Replaces the mushrooms with a field generated from a seed.
+ *
+ * Mushrooms sit on grid cells inside a 1 sprite top, left and right border and
+ * a 3 sprite bottom border. The uniform layout samples distinct cells with
+ * Floyd's algorithm, in time and memory proportional to count rather than to
+ * the field size. The blue-noise layout throws darts tile by tile across the
+ * thread pool, then samples count of the accepted cells the same way. The
+ * same seed always gives the same field, whatever the number of threads.
+ *
+ * @param seed The seed.
+ * @param count The number of mushrooms, fewer are placed if the field runs out of cells.
+ * @param layout How the mushrooms are spread.
+ * @param spacing For BLUE_NOISE, the smallest distance in cells between two mushrooms, counting diagonals as one.
+ */
+void generateMushrooms(uint32_t seed, int count, MushroomLayout layout, int spacing = 2);
+
+/**
+ * @brief Picks distinct values from [0, range) with Floyd's algorithm.
+ *
+ * Takes one random draw per value picked, however large the range is. The
+ * bookkeeping is allocated from the frame arena.
+ *
+ * @param range The number of values to pick from.
+ * @param count The number of values to pick, at most range.
+ * @param gen The generator to draw from.
+ * @param picked Receives the picked values.
+ */
+void sampleDistinctCells(uint32_t range, uint32_t count, std::mt19937& gen, std::pmr::vector<uint32_t>& picked);
+
+/**
+ * @brief Reads the mushroom field options from the command line.
+ *
+ * Recognizes --mushroom-seed followed by a seed and --mushroom-layout followed
+ * by uniform or blue-noise. Without --mushroom-seed, the seed given with
+ * --seed also seeds the fields.
+ *
+ * @param argc The argument count from main.
+ * @param argv The arguments from main.
+ */
+void parseMushroomArgs(int argc, char* argv[]);
+
 /**
  * @brief Adds a mushroom at a specified position.
  * @param x The x-coordinate of the position.
  * @param y The y-coordinate of the position.
+ * @param health The health of the new mushroom, 1 shows it damaged.
+ * @return Entity The new mushroom.
  */
-void addMushroom(int x, int y);
+Entity addMushroom(int x, int y, int health = 2);
 
 /**
- * @brief Draws all mushrooms on the screen.
+ * @brief Damages a mushroom hit by a laser blast, removing it once it has no health left.
+ * @param mushroom The mushroom, which must be live.
  */
-void drawMushrooms();
+void hitMushroom(Entity mushroom);
+
+/**
+ * @brief Takes all of a mushroom's health, leaving it on the field without colliding or drawing.
+ * @param mushroom The mushroom, which must be live.
+ */
+void eatMushroom(Entity mushroom);
+
+/**
+ * @brief Removes one mushroom from the field.
+ * @param mushroom The mushroom, which must be live.
+ */
+void removeMushroom(Entity mushroom);
+
+/**
+ * @brief Returns the collision box of a mushroom.
+ * @param mushroom The mushroom, which must be live.
+ * @return FixedRect The collision box.
+ */
+FixedRect getMushroomBounds(Entity mushroom);
+
+/**
+ * @brief Moves every mushroom down the field, removing the ones that reach a line.
+ * @param dy The distance to move.
+ * @param bottom The line below which mushrooms are removed.
+ */
+void scrollMushrooms(Fixed dy, Fixed bottom);
+
+/**
+ * @brief Removes all mushrooms from the field.
+ */
+void clearMushrooms();
+
+/**
+ * @brief Returns the bounds of every mushroom with health left, packed for batched collision tests.
+ *
+ * Each box's id is the entity index of its mushroom. The boxes are rebuilt on
+ * the first call after a mushroom is added, destroyed or eaten, and stay
+ * valid until the next such change.
+ *
+ * @return const BoxArray& The living mushroom bounds.
+ */
+const BoxArray& getMushroomBoxes();
+
+/**
+ * @brief Returns the version of the boxes last returned by getMushroomBoxes().
+ *
+ * The version changes with every rebuild, so a structure derived from the
+ * boxes only needs redoing when the version differs from the one it was built
+ * from.
+ *
+ * @return uint32_t The version.
+ */
+uint32_t getMushroomBoxesVersion();
 
 extern Texture normalMushroomTexture, damagedMushroomTexture;
-extern std::list<Mushroom> mushrooms;
+
+/**
+ * @brief The mushroom field, one entity per mushroom.
+ *
+ * Every mushroom has a Placement, a Collider the size of the mushroom texture,
+ * a Health of 2 when whole and 1 when damaged, and a Renderable showing the
+ * matching texture. A mushroom with no health left neither collides nor draws.
+ */
+extern EntityStore mushrooms;
 
 #endif
\ No newline at end of file
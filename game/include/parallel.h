@@ -0,0 +1,19 @@
+#ifndef PARALLEL_H
+#define PARALLEL_H
+
+#include <cstddef>
+#include <functional>
+
+/**
+ * @brief Runs a function for every index in [0, count) across the worker threads.
+ *
+ * The calling thread takes part and the call returns once every index has run.
+ * Indices may run in any order and concurrently, so the body must only write
+ * state owned by its own index.
+ *
+ * @param count The number of indices.
+ * @param body The function to run for each index.
+ */
+void parallelFor(size_t count, const std::function<void(size_t)>& body);
+
+#endif
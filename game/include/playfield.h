@@ -0,0 +1,121 @@
+#ifndef PLAYFIELD_H
+#define PLAYFIELD_H
+
+#include "fixedPoint.h"
+#include "globals.h"
+
+/**
+ * @struct FixedPlayfield
+ * @brief Playfield geometry known at compile time, for kernels specialized on it.
+ *
+ * Every member is a constant, so kernels taking a FixedPlayfield compile grid
+ * snapping and cell lookups into multiplications by a constant reciprocal,
+ * or into shifts when the cell size is a power of two, and fold the bounds
+ * of their grid loops. RuntimePlayfield has the same members for any other
+ * geometry. Cells are square.
+ *
+ * @tparam CellPixels The cell size in pixels.
+ * @tparam WidthPixels The playfield width in pixels.
+ * @tparam HeightPixels The playfield height in pixels.
+ */
+template <int CellPixels, int WidthPixels, int HeightPixels>
+struct FixedPlayfield {
+    static_assert(CellPixels > 0 && WidthPixels >= CellPixels && HeightPixels >= CellPixels, "The playfield must hold at least one cell");
+
+    static constexpr Fixed cell = toFixed(CellPixels); ///< The cell size.
+    static constexpr Fixed width = toFixed(WidthPixels); ///< The playfield width.
+    static constexpr Fixed height = toFixed(HeightPixels); ///< The playfield height.
+    static constexpr Fixed gridRight = WidthPixels / CellPixels * cell; ///< The right edge of the last whole column.
+    static constexpr Fixed gridBottom = HeightPixels / CellPixels * cell; ///< The bottom edge of the last whole row.
+
+    /**
+     * @brief Returns the index of the cell a coordinate is in, rounding towards zero.
+     */
+    static constexpr int cellIndex(Fixed value) {return value / cell;};
+
+    /**
+     * @brief Returns a coordinate moved towards zero onto a cell boundary.
+     */
+    static constexpr Fixed snap(Fixed value) {return value / cell * cell;};
+
+    /**
+     * @brief Checks if a coordinate is on a cell boundary.
+     */
+    static constexpr bool isAligned(Fixed value) {return value % cell == 0;};
+};
+
+/**
+ * @struct RuntimePlayfield
+ * @brief Playfield geometry known only at run time, the fallback for custom window and texture sizes.
+ */
+struct RuntimePlayfield {
+    Fixed cell; ///< The cell size.
+    Fixed width; ///< The playfield width.
+    Fixed height; ///< The playfield height.
+    Fixed gridRight; ///< The right edge of the last whole column.
+    Fixed gridBottom; ///< The bottom edge of the last whole row.
+
+    /**
+     * @brief Describes the current window cut into cells of a size.
+     *
+     * @param cell The cell size, positive.
+     */
+    explicit RuntimePlayfield(Fixed cell)
+        : cell(cell), width(toFixed(windowWidth)), height(toFixed(windowHeight)),
+          gridRight(width / cell * cell), gridBottom(height / cell * cell) {};
+
+    /**
+     * @brief Returns the index of the cell a coordinate is in, rounding towards zero.
+     */
+    int cellIndex(Fixed value) const {return value / cell;};
+
+    /**
+     * @brief Returns a coordinate moved towards zero onto a cell boundary.
+     */
+    Fixed snap(Fixed value) const {return value / cell * cell;};
+
+    /**
+     * @brief Checks if a coordinate is on a cell boundary.
+     */
+    bool isAligned(Fixed value) const {return value % cell == 0;};
+};
+
+/**
+ * @brief The geometry of the stock window and textures: 30 pixel cells on a 1080x680 field.
+ */
+using StandardPlayfield = FixedPlayfield<30, 1080, 680>;
+
+/**
+ * @brief Forces every playfield kernel onto the runtime fallback, for comparing the two.
+ *
+ * @param generic true to always use RuntimePlayfield, false to specialize when the geometry matches.
+ */
+void setGenericPlayfield(bool generic);
+
+/**
+ * @brief Checks if setGenericPlayfield() forced the runtime fallback.
+ */
+bool isGenericPlayfield();
+
+/**
+ * @brief Runs a kernel with the playfield geometry of the current window and a cell size.
+ *
+ * The kernel is a generic callable taking the geometry. It gets a
+ * StandardPlayfield when the geometry matches the stock one, so the call
+ * compiles into the specialized kernel, and a RuntimePlayfield otherwise.
+ * Either way it computes the same result.
+ *
+ * @param cell The cell size.
+ * @param kernel The kernel.
+ */
+template <typename Kernel>
+void withPlayfield(Fixed cell, Kernel&& kernel) {
+    if (!isGenericPlayfield() && cell == StandardPlayfield::cell && toFixed(windowWidth) == StandardPlayfield::width
+        && toFixed(windowHeight) == StandardPlayfield::height) {
+        kernel(StandardPlayfield());
+    } else {
+        kernel(RuntimePlayfield(cell));
+    }
+}
+
+#endif
@@ -0,0 +1,170 @@
+#ifndef RENDERBACKEND_H
+#define RENDERBACKEND_H
+
+#include <SFML/Graphics.hpp>
+#include <string>
+#include "framebuffer.h"
+#include "spriteBatch.h"
+
+using namespace sf;
+
+/**
+ * @brief Where frames are drawn.
+ */
+enum class RenderBackend {
+    WINDOW, ///< Drawn by SFML into the window on the GPU.
+    SOFTWARE ///< Rasterized on the CPU into framebuffer, with no window.
+};
+
+/**
+ * @struct RenderConfig
+ * @brief Settings for the render backend.
+ */
+struct RenderConfig {
+    RenderBackend backend = RenderBackend::WINDOW; ///< The backend chosen at startup.
+    long frames = 600; ///< With the software backend, the number of frames to render before exiting.
+    long attractFrames = 120; ///< With the software backend, the frames spent on the HOME screen before a game starts.
+    std::string outputPath; ///< With the software backend, the file the last frame is written to, if any.
+};
+
+/**
+ * @brief Reads the render backend options from the command line.
+ *
+ * Recognizes --render-backend followed by window or software, --render-frames
+ * followed by a frame count and --render-output followed by a PPM file to
+ * write the last software frame to.
+ *
+ * @param argc The argument count from main.
+ * @param argv The arguments from main.
+ */
+void parseRenderArgs(int argc, char* argv[]);
+
+/**
+ * @brief Returns the render backend settings.
+ *
+ * @return const RenderConfig& The settings parsed by parseRenderArgs().
+ */
+const RenderConfig& getRenderConfig();
+
+/**
+ * @brief Selects the backend later draws go to.
+ *
+ * Textures and fonts must be loaded after the backend is selected, since the
+ * software backend keeps their pixels on the CPU instead of uploading them.
+ *
+ * @param backend The backend.
+ */
+void setRenderBackend(RenderBackend backend);
+
+/**
+ * @brief Checks whether frames are rasterized on the CPU.
+ *
+ * @return true with the software backend, false with the window.
+ */
+bool isSoftwareRendering();
+
+/**
+ * @brief Draws a sprite with the selected backend.
+ *
+ * @param sprite The sprite.
+ */
+void drawSprite(const Sprite& sprite);
+
+/**
+ * @brief Draws a sprite batch with the selected backend.
+ *
+ * @param batch The batch.
+ */
+void drawBatch(const SpriteBatch& batch);
+
+/**
+ * @brief Draws a line of text with the selected backend.
+ *
+ * @param text The text.
+ */
+void drawText(const Text& text);
+
+/**
+ * @brief Clears the window or framebuffer to black for a new frame.
+ */
+void beginFrame();
+
+/**
+ * @brief Loads a texture from an image file for the selected backend.
+ *
+ * The window uploads it to the GPU. The software backend only decodes the
+ * file with sf::Image and hands the pixels to the framebuffer, leaving the
+ * sf::Texture empty, so no OpenGL context is created.
+ *
+ * @param texture The texture, which must not move afterwards.
+ * @param path The image file.
+ * @return true if the file was loaded, false otherwise.
+ */
+bool loadTexture(Texture& texture, const std::string& path);
+
+/**
+ * @brief Loads a texture from pixels for the selected backend.
+ *
+ * @param texture The texture, which must not move afterwards.
+ * @param image The pixels.
+ * @return true if the texture was loaded, false otherwise.
+ */
+bool loadTexture(Texture& texture, const Image& image);
+
+/**
+ * @brief Replaces the pixels of a loaded texture, keeping its size.
+ *
+ * @param texture The texture.
+ * @param pixels The RGBA pixels.
+ */
+void updateTexture(Texture& texture, const Uint8* pixels);
+
+/**
+ * @brief Returns a copy of the pixels of a loaded texture.
+ *
+ * @param texture The texture.
+ * @return Image The pixels.
+ */
+Image copyTextureImage(const Texture& texture);
+
+/**
+ * @brief Returns the size of a loaded texture, which sf::Texture::getSize() does not know with the software backend.
+ *
+ * @param texture The texture.
+ * @return Vector2u The size in pixels.
+ */
+Vector2u getTextureSize(const Texture& texture);
+
+/**
+ * @brief Points a sprite at a loaded texture and shows the whole of it.
+ *
+ * Use it instead of sf::Sprite::setTexture() to first give a sprite a texture,
+ * since the sprite cannot take the texture rect from a software texture.
+ *
+ * @param sprite The sprite.
+ * @param texture The texture.
+ */
+void setSpriteTexture(Sprite& sprite, const Texture& texture);
+
+/**
+ * @brief Loads a font for the selected backend.
+ *
+ * The software backend also opens it for rasterizing glyphs on the CPU, see prepareGlyphs().
+ *
+ * @param font The font, which must not move afterwards.
+ * @param path The font file.
+ * @return true if the font was loaded, false otherwise.
+ */
+bool loadFont(Font& font, const std::string& path);
+
+/**
+ * @brief Returns the local bounds of a line of text with the selected backend.
+ *
+ * @param text The text, whose glyphs must be prepared with the software backend.
+ * @return FloatRect The bounds sf::Text::getLocalBounds() reports.
+ */
+FloatRect getTextBounds(const Text& text);
+
+extern Framebuffer framebuffer;
+
+#endif
@@ -0,0 +1,94 @@
+#ifndef SIMULATION_H
+#define SIMULATION_H
+
+#include <cstdint>
+#include <random>
+#include "globals.h"
+#include "taskGraph.h"
+
+/**
+ * @struct GameTickResult
+ * @brief State transitions caused by a single GAME tick.
+ */
+struct GameTickResult {
+    bool waveCleared; ///< The centipede was destroyed and a faster one spawned.
+    bool gameOver; ///< The player ran out of lives and the field was cleared.
+};
+
+/**
+ * @brief Converts latched key flags into the corresponding direction.
+ *
+ * @param keys The InputKey flags returned by latchInputs().
+ * @return Direction The direction corresponding to the pressed arrow key, or Direction::NONE if no arrow key is pressed.
+ */
+Direction getInputs(uint8_t keys);
+
+/**
+ * @brief Reads the simulation options from the command line.
+ *
+ * Recognizes --seed followed by the seed of the simulation random numbers.
+ * Without it the seed given with --mushroom-seed is used, and without either
+ * every game is seeded from std::random_device.
+ *
+ * @param argc The argument count from main.
+ * @param argv The arguments from main.
+ */
+void parseSimulationArgs(int argc, char* argv[]);
+
+/**
+ * @brief Returns the generator every random decision of the simulation draws from.
+ *
+ * Reseeded by startGame(), with the next seed in sequence when seeded, so a
+ * seeded game with the same inputs plays out identically. Only the tasks of
+ * one tick may draw from it, and never two at once.
+ *
+ * @return std::mt19937& The generator.
+ */
+std::mt19937& getSimulationRandom();
+
+/**
+ * @brief Loads the textures and creates the centipede, mushrooms, player and spider.
+ */
+void initGameElements();
+
+/**
+ * @brief Advances the HOME screen attract loop by one tick.
+ */
+void stepHome();
+
+/**
+ * @brief Reseeds the simulation random numbers and resets every game element for a new game.
+ */
+void startGame();
+
+/**
+ * @brief Returns the wave being played.
+ *
+ * @return int The wave, 1 for the first centipede of a game.
+ */
+int getWave();
+
+/**
+ * @brief Adds the tasks of one game tick to a task graph.
+ *
+ * The timers due this tick fire first, then the player moves and shoots,
+ * then loses a life if caught while the blasts advance, then the blasts hit,
+ * then the centipede moves while the spider does, then the spider eats
+ * mushrooms, then the endless field scrolls in endless mode and finally a
+ * cleared wave or game over is handled.
+ *
+ * @param graph The graph to add the tasks to.
+ * @param keys The InputKey flags held, read each time the graph runs.
+ * @param result Receives the state transitions each time the graph runs.
+ */
+void addGameTasks(TaskGraph& graph, const uint8_t& keys, GameTickResult& result);
+
+/**
+ * @brief Advances the game simulation by one tick.
+ *
+ * @param keys The InputKey flags held this tick.
+ * @return GameTickResult The state transitions caused by the tick.
+ */
+GameTickResult stepGame(uint8_t keys);
+
+#endif
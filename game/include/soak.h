@@ -0,0 +1,50 @@
+#ifndef SOAK_H
+#define SOAK_H
+
+#include <cstdint>
+
+/**
+ * @struct SoakConfig
+ * @brief Settings for a headless soak run.
+ */
+struct SoakConfig {
+    double simulatedSeconds = 4 * 3600; ///< The simulated time to run for.
+    double sampleSeconds = 60; ///< The simulated time between samples.
+    double maxThroughputDrop = 0.5; ///< The largest allowed drop in ticks per second, as a fraction of the first sample.
+    double maxRssGrowthMb = 64; ///< The largest allowed growth in resident memory over the first sample.
+};
+
+/**
+ * @brief Parses the soak mode command line options.
+ *
+ * Recognizes --soak [seconds], --soak-sample <seconds>, --soak-max-tps-drop <fraction>
+ * and --soak-max-rss-growth <MB>.
+ *
+ * @param argc The number of command line arguments.
+ * @param argv The command line arguments.
+ * @param config Receives the parsed settings.
+ * @return true if soak mode was requested, false otherwise.
+ */
+bool parseSoakArgs(int argc, char* argv[], SoakConfig& config);
+
+/**
+ * @brief Runs the attract loop and game with an automated player, uncapped and without a window.
+ *
+ * Ticks per second, resident memory and entity counts are sampled at a fixed
+ * simulated interval and compared against the first sample.
+ *
+ * @param config The soak settings.
+ * @return int 0 if the run stayed within its thresholds, 1 otherwise.
+ */
+int runSoak(const SoakConfig& config);
+
+/**
+ * @brief Chooses the automated player's inputs: always fire and line up under the nearest head.
+ *
+ * Also plays the games rendered by the software backend.
+ *
+ * @return uint8_t The InputKey flags to hold this tick.
+ */
+uint8_t autoPlayerKeys();
+
+#endif
@@ -4,18 +4,24 @@
 #include <SFML/Graphics.hpp>
 #include <random>
 #include "mushroom.h"
+#include "entities.h"
+#include "spriteBatch.h"
+#include "timerWheel.h"
 #include "globals.h"
+#include "collisionEvents.h"
 
 using namespace sf;
 
 /**
  * @class Spider
- * @brief Represents a spider character in the game, inheriting from Sprite.
+ * @brief Represents a spider character in the game.
  * 
- * The Spider class handles the behavior and properties of a spider character,
- * including movement, collision detection, and rendering.
+ * The spider is an entity with a Placement, a Collider the size of its first
+ * texture, a Health of 1 while alive, a Renderable, an Animation and a Motion.
+ * The Spider class holds the systems that move, feed and draw it from those
+ * components, and the respawn timer.
  */
-class Spider : public Sprite {
+class Spider {
     public:
         /**
          * @brief Constructs a Spider object with a specified speed.
@@ -24,12 +30,15 @@ class Spider : public Sprite {
         Spider(int speed);
 
         /**
-         * @brief Updates the spider's state.
+         * @brief Moves the spider if it is alive.
+         *
+         * Eating mushrooms is left to the collision events reported by
+         * detectMeals(), so moving the spider never touches the mushroom field.
          */
         void update();
 
         /**
-         * @brief Resets the spider to its initial state.
+         * @brief Resets the spider to its initial state, cancelling a pending respawn.
          */
         void reset(bool resetSpeed=true);
 
@@ -39,34 +48,33 @@ class Spider : public Sprite {
         void changeDirection();
 
         /**
-         * @brief Checks for collisions with mushrooms.
+         * @brief Reports every mushroom the living spider overlaps, to be eaten.
+         *
+         * @param events Receives one event per mushroom.
          */
-        void checkMushroomCollision();
+        void detectMeals(CollisionQueue& events);
 
         /**
          * @brief Draws the spider on the screen.
          */
         void draw();
 
-        /**
-         * @brief Sets the status of the spider.
-         * @param status The new status of the spider.
-         */
-        void setStatus(CharacterStatus status);
-
         /**
          * @brief Gets the current status of the spider.
-         * @return The current status of the spider.
+         * @return ALIVE while the spider has health left, DEAD otherwise.
          */
-        CharacterStatus getStatus() {return status;};
+        CharacterStatus getStatus() const {
+            return (entities.healths.get(entity)->hitPoints > 0) ? CharacterStatus::ALIVE : CharacterStatus::DEAD;
+        };
 
         /**
-         * @brief Rotates the spider's texture.
+         * @brief Gets the collision box of the spider.
+         * @return The collision box.
          */
-        void rotateTexture();
+        FixedRect getFixedBounds() const {return entities.getBounds(entity);};
 
         /** 
-         * @brief Handles collisions with other objects.
+         * @brief Kills the spider and schedules its respawn on the game timers once the spawn delay has passed.
          */
         void handleCollision();
         
@@ -74,29 +82,28 @@ class Spider : public Sprite {
          * @brief Gets the next position of the spider.
          * @return The next position of the spider.
          */
-        Vector2f getNextPosition();
+        FixedVec getNextPosition();
 
         /**
          * @brief Gets the speed of the spider.
          * @return The speed of the spider.
          */
-        int getSpeed() {return speed;};
+        int getSpeed() const {return toPixels(entities.motions.get(entity)->speed);};
 
         /**
          * @brief Sets the speed of the spider.
          * @param speed The new speed of the spider.
          */
-        void setSpeed(int speed) {this->speed = speed;};
+        void setSpeed(int speed) {entities.motions.get(entity)->speed = toFixed(speed);};
 
     private:
+        EntityStore entities; ///< Holds the spider.
+        Entity entity; ///< The spider.
+        SpriteBatch batch; ///< The spider's quad of the frame being drawn.
         int initialSpeed; ///< The initial speed of the spider.
-        int speed; ///< The speed at which the spider moves.
-        int dx, dy; ///< The direction of the spider's movement.
-        CharacterStatus status; ///< The current status of the spider.
-        int animationTick; ///< The current animation tick.
-        int textureIndex; ///< The index of the current texture.
-        int spawnDelay; ///< The delay before the spider spawns.
-        Clock spawnClock; ///< The clock used to track spawn timing.
+        float spawnDelay; ///< The game time in seconds before a dead spider respawns.
+        Timer respawnTimer; ///< Pending while the spider is dead, respawns it when it fires.
+        std::vector<uint64_t> hitMask; ///< Reused mushroom hit mask, one bit per mushroom box.
 };
 
 /**
@@ -118,12 +125,12 @@ int getRandomDirection();
 bool getRandomChance(int percentage);
 
 /**
- * @brief Generates a random float within a specified range.
+ * @brief Generates a random fixed-point value within a specified range.
  * @param min The minimum value of the range.
  * @param max The maximum value of the range.
- * @return A random float between min and max.
+ * @return A random fixed-point value between min and max, inclusive.
  */
-float getRandomFloat(float min, float max);
+Fixed getRandomFixed(Fixed min, Fixed max);
 
 extern std::vector<Texture> spiderTextures;
 extern Spider spider;
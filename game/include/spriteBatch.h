@@ -0,0 +1,101 @@
+#ifndef SPRITEBATCH_H
+#define SPRITEBATCH_H
+
+#include <SFML/Graphics.hpp>
+#include <vector>
+#include "entities.h"
+#include "framebuffer.h"
+
+using namespace sf;
+
+/**
+ * @struct OrientationTransform
+ * @brief The rotation, scale and origin that turn a texture to face one orientation.
+ */
+struct OrientationTransform {
+    float rotation = 0.0f; ///< The rotation in degrees.
+    Vector2f scale = Vector2f(1.0f, 1.0f); ///< The scale, negative to mirror.
+    Vector2f origin; ///< The origin keeping the turned texture over the same box.
+};
+
+/**
+ * @brief Returns the transform for an orientation of a texture size.
+ *
+ * The transforms of all orientations are computed together the first time a
+ * texture size is seen. Only called from the drawing thread.
+ *
+ * @param orientation The orientation.
+ * @param textureSize The size of the texture being turned.
+ * @return const OrientationTransform& The transform.
+ */
+const OrientationTransform& getOrientationTransform(Orientation orientation, Vector2u textureSize);
+
+/**
+ * @class SpriteBatch
+ * @brief Textured quads grouped by texture, drawn with one call per texture.
+ *
+ * Clearing keeps every vertex array's storage, so a batch rebuilt each time
+ * with about the same contents stops allocating once it has grown.
+ */
+class SpriteBatch {
+    public:
+        /**
+         * @brief Removes every quad, keeping the allocated storage.
+         */
+        void clear();
+
+        /**
+         * @brief Appends a quad showing a whole texture.
+         *
+         * @param texture The texture.
+         * @param position The top left corner of the quad, the quad is the size of the texture.
+         * @param orientation The direction the texture is turned to face within the quad.
+         */
+        void add(const Texture& texture, const Vector2f& position, Orientation orientation = Orientation::NONE);
+
+        /**
+         * @brief Draws every quad onto a render target, one draw call per texture.
+         *
+         * @param target The target to draw onto.
+         */
+        void draw(RenderTarget& target) const;
+
+        /**
+         * @brief Blends every quad onto a software frame.
+         *
+         * @param target The frame to draw onto.
+         */
+        void draw(Framebuffer& target) const;
+
+        /**
+         * @brief Returns the number of quads.
+         */
+        size_t size() const;
+
+    private:
+        /**
+         * @struct Layer
+         * @brief The quads of one texture.
+         */
+        struct Layer {
+            const Texture* texture; ///< The texture every quad of the layer shows.
+            VertexArray quads; ///< Four vertices per quad.
+        };
+
+        std::vector<Layer> layers; ///< One layer per texture seen since the batch was created.
+};
+
+/**
+ * @brief Batches every entity of a store that has a placement and a renderable.
+ *
+ * The render system: it only reads the components, turning each texture to
+ * its renderable's orientation. Entities with a health component and no hits
+ * left are skipped.
+ *
+ * @param store The entities.
+ * @param batch Receives the quads, appended to what it already holds.
+ * @param area If not null, only entities overlapping this area are batched.
+ */
+void batchEntities(const EntityStore& store, SpriteBatch& batch, const FloatRect* area = nullptr);
+
+#endif
@@ -0,0 +1,61 @@
+#ifndef SPSCQUEUE_H
+#define SPSCQUEUE_H
+
+#include <array>
+#include <atomic>
+#include <cstddef>
+
+/**
+ * @class SpscQueue
+ * @brief A fixed-capacity lock-free queue for exactly one producer and one consumer thread.
+ *
+ * The producer only writes the tail and the consumer only writes the head, so
+ * neither side ever blocks or allocates.
+ *
+ * @tparam T The type of element stored.
+ * @tparam Capacity The maximum number of queued elements, must be a power of two.
+ */
+template <typename T, size_t Capacity>
+class SpscQueue {
+    static_assert((Capacity & (Capacity - 1)) == 0, "SpscQueue capacity must be a power of two");
+
+    public:
+        /**
+         * @brief Pushes an element from the producer thread.
+         *
+         * @param value The element to push.
+         * @return true if the element was queued, false if the queue is full.
+         */
+        bool push(const T& value) {
+            size_t tail = this->tail.load(std::memory_order_relaxed);
+            if (tail - head.load(std::memory_order_acquire) == Capacity) {
+                return false;
+            }
+            buffer[tail & (Capacity - 1)] = value;
+            this->tail.store(tail + 1, std::memory_order_release);
+            return true;
+        };
+
+        /**
+         * @brief Pops an element from the consumer thread.
+         *
+         * @param value Receives the popped element.
+         * @return true if an element was popped, false if the queue is empty.
+         */
+        bool pop(T& value) {
+            size_t head = this->head.load(std::memory_order_relaxed);
+            if (head == tail.load(std::memory_order_acquire)) {
+                return false;
+            }
+            value = buffer[head & (Capacity - 1)];
+            this->head.store(head + 1, std::memory_order_release);
+            return true;
+        };
+
+    private:
+        std::array<T, Capacity> buffer; ///< The ring buffer storage.
+        alignas(64) std::atomic<size_t> head{0}; ///< The next slot to pop, written by the consumer.
+        alignas(64) std::atomic<size_t> tail{0}; ///< The next slot to push, written by the producer.
+};
+
+#endif
@@ -0,0 +1,110 @@
+#ifndef TASKGRAPH_H
+#define TASKGRAPH_H
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <deque>
+#include <functional>
+#include <vector>
+
+/**
+ * @brief The shared game state a task can declare it reads or writes.
+ */
+enum Resource : uint32_t {
+    RES_PLAYER = 1 << 0, ///< The player's position and reload state.
+    RES_LIVES = 1 << 1, ///< The player's remaining lives.
+    RES_SCORE = 1 << 2, ///< The player's score and high score.
+    RES_BLASTS = 1 << 3, ///< The laser blasts in flight.
+    RES_CENTIPEDE = 1 << 4, ///< The centipede segments.
+    RES_MUSHROOMS = 1 << 5, ///< The mushroom field.
+    RES_SPIDER = 1 << 6, ///< The spider.
+    RES_FIELD_LAYER = 1 << 7, ///< The cached field layer's stale areas.
+    RES_HUD = 1 << 8, ///< The HUD text and life sprites.
+    RES_FRAME_ARENA = 1 << 9, ///< The frame arena, which is not thread-safe.
+    RES_TIMERS = 1 << 10, ///< The game timer wheel, which is not thread-safe.
+    RES_PLAYER_HITS = 1 << 11, ///< The player hit events awaiting resolution.
+    RES_BLAST_HITS = 1 << 12, ///< The laser blast hit events awaiting resolution.
+    RES_SPIDER_MEALS = 1 << 13, ///< The spider meal events awaiting resolution.
+    RES_COUNT = 14
+};
+
+/**
+ * @class TaskGraph
+ * @brief Runs a fixed set of update tasks on the thread pool, overlapping the ones that do not conflict.
+ *
+ * Tasks are added in the order they would run serially, each declaring the
+ * resources it reads and writes. A task depends on every earlier task that
+ * writes something it touches or reads something it writes, so a run always
+ * produces the same result as running the tasks in order. The graph is built
+ * once and run every tick.
+ *
+ * Tasks must not touch the window or any other OpenGL state, that stays on the
+ * main thread.
+ */
+class TaskGraph {
+    public:
+        /**
+         * @brief Adds a task after every task added so far.
+         *
+         * @param name The name shown in the graph dump.
+         * @param reads The Resource flags the task reads.
+         * @param writes The Resource flags the task writes.
+         * @param body The work of the task.
+         */
+        void addTask(const char* name, uint32_t reads, uint32_t writes, std::function<void()> body);
+
+        /**
+         * @brief Runs every task once, returning when all have finished.
+         *
+         * The calling thread takes part in running the tasks.
+         */
+        void run();
+
+        /**
+         * @brief Writes the tasks and their dependencies in Graphviz DOT format.
+         *
+         * Every edge is labelled with the resources causing it, and every task
+         * with its average run time so far.
+         *
+         * @param file The file to write to.
+         */
+        void writeDot(FILE* file) const;
+
+        /**
+         * @brief Returns the number of tasks.
+         */
+        size_t size() const {return tasks.size();};
+
+    private:
+        /**
+         * @struct Task
+         * @brief A task and its place in the graph.
+         */
+        struct Task {
+            const char* name; ///< The name of the task.
+            uint32_t reads; ///< The Resource flags the task reads.
+            uint32_t writes; ///< The Resource flags the task writes.
+            std::function<void()> body; ///< The work of the task.
+            std::vector<size_t> successors; ///< The tasks waiting on this one.
+            std::vector<uint32_t> successorResources; ///< The resources causing each successor edge.
+            size_t dependencyCount = 0; ///< The number of tasks this one waits on.
+            std::atomic<size_t> remaining{0}; ///< Dependencies not yet finished in the current run.
+            std::chrono::steady_clock::duration totalTime{}; ///< Time spent running the task across all runs.
+            long runs = 0; ///< The number of times the task has run.
+        };
+
+        /**
+         * @brief Runs a task, then queues every successor it was the last dependency of.
+         *
+         * @param context The TaskGraph.
+         * @param index The index of the task.
+         */
+        static void runTask(void* context, size_t index);
+
+        std::deque<Task> tasks; ///< The tasks in the order they were added.
+        std::atomic<size_t> pending{0}; ///< Tasks not yet finished in the current run.
+};
+
+#endif
@@ -0,0 +1,137 @@
+#ifndef TELEMETRY_H
+#define TELEMETRY_H
+
+#include <chrono>
+#include <cstdint>
+
+/**
+ * @brief The parts of a tick timed in each telemetry record.
+ */
+enum TelemetryPhase : uint32_t {
+    PHASE_SIMULATE, ///< Stepping the HOME attract loop or running the GAME task graph.
+    PHASE_DRAW, ///< Drawing the field, entities and HUD.
+    PHASE_PRESENT, ///< Handing the frame to the window, not counting the wait for the next frame.
+    PHASE_COUNT
+};
+
+const uint32_t telemetryVersion = 1; ///< The current telemetry format version.
+
+/**
+ * @struct TelemetryHeader
+ * @brief The header at the start of a telemetry stream.
+ *
+ * A telemetry stream is this header followed by one TelemetryRecord per tick,
+ * in tick order, with nothing in between. All fields are little-endian.
+ */
+struct TelemetryHeader {
+    char magic[4]; ///< Always "CPTL".
+    uint32_t version; ///< The format version, currently 1.
+    uint32_t recordSize; ///< The size of each record in bytes.
+    uint32_t phaseCount; ///< The number of phase timings in each record.
+};
+
+/**
+ * @struct TelemetryRecord
+ * @brief The game state and timings of one tick.
+ */
+struct TelemetryRecord {
+    uint32_t tick; ///< The tick number, counting from 0 at startup.
+    uint8_t screen; ///< 0 on the HOME screen, 1 in a GAME.
+    uint8_t lives; ///< The player's remaining lives.
+    uint16_t wave; ///< The wave being played.
+    uint32_t segments; ///< The number of living centipede segments.
+    uint32_t mushrooms; ///< The number of mushrooms on the field.
+    uint32_t blasts; ///< The number of laser blasts in flight.
+    uint32_t collisionTests; ///< The box tests the batched collision kernels performed during the tick.
+    int32_t score; ///< The player's score.
+    uint32_t phaseMicros[PHASE_COUNT]; ///< The time spent in each TelemetryPhase, in microseconds.
+};
+
+static_assert(sizeof(TelemetryRecord) == 28 + 4 * PHASE_COUNT, "TelemetryRecord must have no padding");
+
+/**
+ * @class TelemetryPhases
+ * @brief Times the phases of one tick for its telemetry record.
+ */
+class TelemetryPhases {
+    public:
+        /**
+         * @brief Clears the timings and starts timing the first phase.
+         */
+        void begin() {
+            for (uint32_t& micros : phaseMicros) {
+                micros = 0;
+            }
+            mark = std::chrono::steady_clock::now();
+        };
+
+        /**
+         * @brief Adds the time since the last mark to a phase and starts timing the next one.
+         *
+         * @param phase The phase that just finished.
+         */
+        void end(TelemetryPhase phase) {
+            std::chrono::steady_clock::time_point now = std::chrono::steady_clock::now();
+            phaseMicros[phase] += static_cast<uint32_t>(std::chrono::duration_cast<std::chrono::microseconds>(now - mark).count());
+            mark = now;
+        };
+
+        /**
+         * @brief Restarts the timer without charging the time since the last mark to any phase.
+         */
+        void skip() {
+            mark = std::chrono::steady_clock::now();
+        };
+
+        uint32_t phaseMicros[PHASE_COUNT] = {}; ///< The time spent in each phase so far.
+
+    private:
+        std::chrono::steady_clock::time_point mark; ///< The end of the last timed phase.
+};
+
+/**
+ * @brief Reads the telemetry options from the command line.
+ *
+ * Recognizes --telemetry followed by the file to write the stream to.
+ *
+ * @param argc The argument count from main.
+ * @param argv The arguments from main.
+ */
+void parseTelemetryArgs(int argc, char* argv[]);
+
+/**
+ * @brief Opens the stream and starts the writer thread if parseTelemetryArgs() found a file.
+ *
+ * Registers telemetryShutdown() to run at exit, so the stream is completed
+ * however the program ends.
+ */
+void telemetryInit();
+
+/**
+ * @brief Checks whether a telemetry stream is being written.
+ *
+ * @return true if telemetry is enabled, false otherwise.
+ */
+bool isTelemetryEnabled();
+
+/**
+ * @brief Appends the record of the tick that just finished.
+ *
+ * Gathers the entity counts, score, wave and collision tests itself. Never
+ * blocks: records go into one of two fixed buffers while a background thread
+ * writes out the other, and if both are full the records are dropped and
+ * counted instead. Does nothing when telemetry is disabled.
+ *
+ * @param screen 0 for the HOME screen, 1 for a GAME.
+ * @param phases The timings of the tick.
+ */
+void recordTelemetryTick(uint8_t screen, const TelemetryPhases& phases);
+
+/**
+ * @brief Writes out the buffered records, stops the writer thread and reports how many were written.
+ *
+ * Does nothing if telemetry is not running, so calling it again at exit is harmless.
+ */
+void telemetryShutdown();
+
+#endif
@@ -0,0 +1,53 @@
+#ifndef TEXTUREVARIANTS_H
+#define TEXTUREVARIANTS_H
+
+#include <SFML/Graphics.hpp>
+
+using namespace sf;
+
+const int textureVariantCount = 3; ///< The number of color variants each wave cycles through.
+
+/**
+ * @brief Registers a texture whose colors rotate with the waves.
+ *
+ * Keeps a copy of the texture's pixels as variant 0. Variant k rotates the
+ * RGB channels of every pixel k times. Variants are built on first use, or
+ * ahead of it by prefetchTextureVariant(), and the selected one is written
+ * into the registered texture itself with updateTexture(), so sprites keep
+ * pointing at the same texture and only one copy of each is ever on the GPU,
+ * or in the software backend's images.
+ *
+ * @param texture The texture, which must outlive the registration.
+ */
+void addTextureVariants(Texture& texture);
+
+/**
+ * @brief Starts building the pixels of a variant on the thread pool, unless they are built or being built.
+ *
+ * @param index The variant, in [0, textureVariantCount).
+ */
+void prefetchTextureVariant(int index);
+
+/**
+ * @brief Uploads a variant into every registered texture and prefetches the one after it.
+ *
+ * Builds the variant first if no prefetch did, waiting for a prefetch still in
+ * flight. Must be called from the thread that owns the textures.
+ *
+ * @param index The variant, in [0, textureVariantCount).
+ */
+void selectTextureVariant(int index);
+
+/**
+ * @brief Returns the variant last selected.
+ *
+ * @return int The variant, 0 until selectTextureVariant() is first called.
+ */
+int getTextureVariant();
+
+/**
+ * @brief Prints how many variants were built and how many selections found theirs ready.
+ */
+void reportTextureVariants();
+
+#endif
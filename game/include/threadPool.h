@@ -0,0 +1,108 @@
+#ifndef THREADPOOL_H
+#define THREADPOOL_H
+
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+/**
+ * @struct PoolJob
+ * @brief A unit of work run by the thread pool.
+ *
+ * Jobs are a plain function and context pointer so queuing one never allocates.
+ */
+struct PoolJob {
+    void (*run)(void* context, size_t index); ///< The function to run.
+    void* context; ///< The context passed to the function.
+    size_t index; ///< The index passed to the function.
+};
+
+/**
+ * @class ThreadPool
+ * @brief A work-stealing pool of worker threads shared by the whole game.
+ *
+ * Every worker owns a queue, and threads outside the pool share one more. A
+ * thread pushes and pops jobs at the back of its own queue and, once it runs
+ * dry, steals from the front of the others. Callers never block on the pool:
+ * they help run queued jobs until the work they are waiting on has finished,
+ * so nested submissions from inside a job cannot deadlock.
+ */
+class ThreadPool {
+    public:
+        /**
+         * @brief Returns the pool, starting hardware_concurrency() - 1 workers on first use.
+         *
+         * @return ThreadPool& The shared pool.
+         */
+        static ThreadPool& instance();
+
+        ~ThreadPool();
+
+        /**
+         * @brief Queues a job on the calling thread's queue.
+         *
+         * @param job The job to queue.
+         */
+        void submit(const PoolJob& job);
+
+        /**
+         * @brief Runs queued jobs on the calling thread until a counter reaches zero.
+         *
+         * @param pending The counter to wait on, decremented by the jobs being waited for.
+         */
+        void helpUntilDone(const std::atomic<size_t>& pending);
+
+        /**
+         * @brief Returns the number of worker threads, not counting callers.
+         */
+        size_t getWorkerCount() const {return workers.size();};
+
+    private:
+        static const size_t queueCapacity = 1024; ///< The most jobs a single queue holds.
+
+        /**
+         * @struct JobQueue
+         * @brief A fixed-capacity double-ended job queue guarded by a mutex.
+         */
+        struct JobQueue {
+            std::mutex mutex; ///< Guards the queue.
+            PoolJob jobs[queueCapacity]; ///< The ring buffer of jobs.
+            size_t head = 0; ///< The index of the oldest job.
+            size_t count = 0; ///< The number of queued jobs.
+        };
+
+        ThreadPool();
+
+        /**
+         * @brief Finds a job, trying the thread's own queue first and then stealing.
+         *
+         * @param queueIndex The queue owned by the calling thread.
+         * @param job Receives the job.
+         * @return true if a job was found, false if every queue was empty.
+         */
+        bool findJob(size_t queueIndex, PoolJob& job);
+
+        /**
+         * @brief Returns the queue owned by the calling thread.
+         */
+        size_t ownQueue() const;
+
+        /**
+         * @brief Runs jobs until the pool is destroyed, sleeping while there are none.
+         *
+         * @param queueIndex The queue owned by the worker.
+         */
+        void workerLoop(size_t queueIndex);
+
+        std::vector<JobQueue> queues; ///< One queue per worker, the last shared by outside threads.
+        std::vector<std::thread> workers; ///< The worker threads.
+        std::atomic<size_t> queuedJobs{0}; ///< The number of jobs queued across all queues.
+        std::mutex sleepMutex; ///< Guards sleeping and waking workers.
+        std::condition_variable wake; ///< Signals sleeping workers that a job was queued.
+        bool stopping = false; ///< Whether the workers should exit.
+};
+
+#endif
@@ -0,0 +1,140 @@
+#ifndef TIMERWHEEL_H
+#define TIMERWHEEL_H
+
+#include <cstddef>
+#include <cstdint>
+
+class TimerWheel;
+
+/**
+ * @class Timer
+ * @brief A callback scheduled on a TimerWheel, owned by whoever schedules it.
+ *
+ * The wheel links pending timers through the timers themselves, so scheduling
+ * never allocates. A pending timer is cancelled when it is destroyed or
+ * assigned to, and a copy of a timer is never pending.
+ */
+class Timer {
+    public:
+        Timer() = default;
+        Timer(const Timer&) {};
+        Timer& operator=(const Timer&) {cancel(); return *this;};
+        ~Timer() {cancel();};
+
+        /**
+         * @brief Removes the timer from its wheel without calling its callback.
+         */
+        void cancel();
+
+        /**
+         * @brief Checks if the timer is scheduled and has not expired yet.
+         *
+         * @return true if the timer is pending, false otherwise.
+         */
+        bool isPending() const {return wheel != nullptr;};
+
+    private:
+        friend class TimerWheel;
+
+        void (*callback)(void*) = nullptr; ///< Called when the timer expires, may be null.
+        void* context = nullptr; ///< Passed to the callback.
+        uint64_t expires = 0; ///< The tick the timer expires on.
+        TimerWheel* wheel = nullptr; ///< The wheel the timer is pending on, null when not pending.
+        Timer* next = nullptr; ///< The next timer in the same slot.
+        Timer** link = nullptr; ///< The pointer that points at this timer, for unlinking in O(1).
+};
+
+/**
+ * @class TimerWheel
+ * @brief Fires timers after a number of ticks, with O(1) scheduling and cancelling.
+ *
+ * A hierarchical wheel of levels slots each. Level 0 holds the timers due in
+ * the next slots ticks, one slot per tick, and each further level holds
+ * timers slots times further out in coarser slots. When level 0 wraps around,
+ * the next slot of level 1 is cascaded down, and so on up the levels, so a
+ * timer is only touched a handful of times between being scheduled and firing.
+ * Nothing is polled per pending timer, advance() only visits the slot that is due.
+ *
+ * Not thread-safe, tasks scheduling or firing timers declare the RES_TIMERS resource.
+ */
+class TimerWheel {
+    public:
+        /**
+         * @brief Schedules a timer, rescheduling it if it is already pending.
+         *
+         * A timer without a callback only marks a delay, see Timer::isPending().
+         *
+         * @param timer The timer, which must stay in place until it fires or is cancelled.
+         * @param delay The number of ticks until the timer fires, at least one.
+         * @param callback Called with context when the timer fires, may be null.
+         * @param context Passed to the callback.
+         */
+        void schedule(Timer& timer, uint32_t delay, void (*callback)(void*) = nullptr, void* context = nullptr);
+
+        /**
+         * @brief Advances the wheel by one tick, firing every timer that expires on it.
+         *
+         * Callbacks may schedule timers, including the one that fired.
+         */
+        void advance();
+
+        /**
+         * @brief Returns the number of ticks advanced so far.
+         *
+         * @return uint64_t The current tick.
+         */
+        uint64_t getTick() const {return tick;};
+
+        /**
+         * @brief Returns the number of pending timers.
+         *
+         * @return size_t The number of pending timers.
+         */
+        size_t getPendingCount() const {return pendingCount;};
+
+    private:
+        friend class Timer;
+
+        static const int levelBits = 6; ///< Each level has 1 << levelBits slots.
+        static const int slots = 1 << levelBits; ///< The number of slots per level.
+        static const int levels = 4; ///< The number of levels, covering delays of up to slots^levels - 1 ticks.
+
+        /**
+         * @brief Links a timer into the slot of its expiry tick.
+         *
+         * @param timer The timer, with expires set.
+         */
+        void insert(Timer& timer);
+
+        /**
+         * @brief Moves every timer of a slot to the slots matching the current tick.
+         *
+         * @param level The level of the slot.
+         * @param slot The slot index.
+         */
+        void cascade(int level, int slot);
+
+        Timer* heads[levels][slots] = {}; ///< The first timer of every slot.
+        uint64_t tick = 0; ///< The current tick.
+        size_t pendingCount = 0; ///< The number of pending timers.
+};
+
+/**
+ * @brief The number of game ticks per second of game time.
+ */
+const int gameTicksPerSecond = 60;
+
+/**
+ * @brief Converts game time to game ticks, rounding to the nearest tick.
+ *
+ * @param seconds The game time.
+ * @return uint32_t The number of ticks.
+ */
+uint32_t secondsToTicks(float seconds);
+
+/**
+ * @brief The wheel advanced once per game tick, for spawn delays, reload cooldowns and other timed events.
+ */
+extern TimerWheel gameTimers;
+
+#endif
@@ -0,0 +1,8 @@
+#include "animation.h"
+
+uint32_t animationTick = 0;
+
+void animationAdvance() {
+    // Wraps after about two years at 60 frames per second, getAnimationFrame() handles the wrap
+    animationTick++;
+}
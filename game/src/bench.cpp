@@ -0,0 +1,460 @@
+#include "bench.h"
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <random>
+#include <unordered_set>
+#include <vector>
+#include "animation.h"
+#include "boxArray.h"
+#include "centipede.h"
+#include "fieldLayer.h"
+#include "frameArena.h"
+#include "laserBlaster.h"
+#include "mushroom.h"
+#include "playfield.h"
+#include "renderBackend.h"
+#include "simulation.h"
+#include "soak.h"
+#include "spider.h"
+
+using SteadyClock = std::chrono::steady_clock;
+
+bool parseBenchArgs(int argc, char* argv[], BenchConfig& config) {
+    bool bench = false;
+    for (int i = 1; i < argc; ++i) {
+        if (strcmp(argv[i], "--bench") == 0 && i + 1 < argc) {
+            bench = true;
+            config.name = argv[++i];
+            if (i + 1 < argc && argv[i + 1][0] != '-') config.count = atoi(argv[++i]);
+        } else if (strcmp(argv[i], "--bench-ticks") == 0 && i + 1 < argc) {
+            config.ticks = atoi(argv[++i]);
+        }
+    }
+    return bench;
+}
+
+/**
+ * @brief Places a fixed pseudo-random mushroom field so every run sees the same obstacles.
+ */
+static void placeBenchMushrooms() {
+    clearMushrooms();
+    int size = getTextureSize(normalMushroomTexture).x;
+    unsigned int state = 12345;
+    for (int i = 0; i < 60; ++i) {
+        state = state * 1103515245 + 12345;
+        int col = 1 + (state >> 16) % (windowWidth / size - 2);
+        state = state * 1103515245 + 12345;
+        int row = 1 + (state >> 16) % (windowHeight / size - 4);
+        addMushroom(col * size, row * size);
+    }
+}
+
+/**
+ * @brief Rebuilds the centipede as many independent three-segment chains spread over the field.
+ *
+ * @param chains The number of chains.
+ */
+static void buildHeadScenario(int chains) {
+    centipede = ECE_Centipede(chains * 4, 2);
+    EntityStore& segments = centipede.getSegments();
+    int size = getTextureSize(headTextures[0]).x;
+    int columns = windowWidth / size / 4;
+
+    // Lay the chains out in rows, then split them by killing every fourth segment
+    for (int chain = 0; chain < chains; ++chain) {
+        float x = (chain % columns) * 4 * size + 2 * size;
+        float y = (chain / columns) % (windowHeight / size - 3) * size;
+        for (int i = 0; i < 4; ++i) {
+            segments.placements.get(segments.entityAt(chain * 4 + i))->position = {fromFloat(x - i * size), fromFloat(y)};
+        }
+    }
+    for (int chain = 0; chain < chains; ++chain) {
+        if (chain + 1 < chains) {
+            centipede.killSegment(segments.entityAt(chain * 4 + 3));
+        }
+    }
+}
+
+/**
+ * @brief Hashes the position and direction of every living segment.
+ *
+ * @return unsigned long The state hash.
+ */
+static unsigned long hashCentipede() {
+    unsigned long hash = 1469598103934665603UL;
+    EntityStore& segments = centipede.getSegments();
+    for (size_t i = 0; i < segments.motions.size(); ++i) {
+        Entity segment = segments.motions.entityAt(i);
+        if (!centipede.isLiving(segment)) continue;
+        const Motion& motion = segments.motions[i];
+        FixedVec position = segments.placements.get(segment)->position;
+        long values[4] = {position.x, position.y, motion.dx, motion.dy};
+        for (long value : values) {
+            hash = (hash ^ static_cast<unsigned long>(value)) * 1099511628211UL;
+        }
+    }
+    return hash;
+}
+
+/**
+ * @brief Times the heads scenario with a given parallel threshold.
+ *
+ * @param chains The number of chains.
+ * @param ticks The number of ticks to run.
+ * @param threshold The parallel head threshold, 0 for serial.
+ * @param hash Receives the final state hash.
+ * @return double The ticks per second achieved.
+ */
+static double timeHeads(int chains, int ticks, size_t threshold, unsigned long& hash) {
+    buildHeadScenario(chains);
+    centipede.setParallelHeadThreshold(threshold);
+    SteadyClock::time_point start = SteadyClock::now();
+    for (int tick = 0; tick < ticks; ++tick) {
+        centipede.move();
+        centipede.applyOrientations();
+        frameArenaReset();
+    }
+    double seconds = std::chrono::duration<double>(SteadyClock::now() - start).count();
+    hash = hashCentipede();
+    return ticks / seconds;
+}
+
+/**
+ * @brief Compares serial and parallel head moves on a many-head scenario.
+ *
+ * @param config The benchmark settings.
+ * @return int 0 if both runs ended in the same state, 1 otherwise.
+ */
+static int benchHeads(const BenchConfig& config) {
+    int chains = (config.count > 0) ? config.count : 128;
+    placeBenchMushrooms();
+
+    unsigned long serialHash, parallelHash;
+    double serialTps = timeHeads(chains, config.ticks, 0, serialHash);
+    double turnsPerTick = static_cast<double>(centipede.getOrientationUpdates()) / config.ticks;
+    int segmentCount = centipede.getLiveCount();
+    double parallelTps = timeHeads(chains, config.ticks, 1, parallelHash);
+
+    // Run serially again with the head kernels on the runtime playfield geometry
+    setGenericPlayfield(true);
+    unsigned long genericHash;
+    double genericTps = timeHeads(chains, config.ticks, 0, genericHash);
+    setGenericPlayfield(false);
+
+    bool identical = serialHash == parallelHash && serialHash == genericHash;
+    printf("heads: %d chains, %d ticks\n", chains, config.ticks);
+    printf("  serial   %10.0f ticks/s\n", serialTps);
+    printf("  parallel %10.0f ticks/s (%.2fx)\n", parallelTps, parallelTps / serialTps);
+    printf("  generic  %10.0f ticks/s serial on the runtime playfield (%.2fx)\n", genericTps, genericTps / serialTps);
+    printf("  results %s\n", identical ? "identical" : "DIFFER");
+    printf("  orientation updates %.2f per tick for %d segments\n", turnsPerTick, segmentCount);
+    return identical ? 0 : 1;
+}
+
+/**
+ * @brief Compares FixedRect::intersects loops against the batched box kernel.
+ *
+ * Every tick tests the same 64 query boxes against every target box, counting
+ * the hits both ways and with firstHit() scans, and checks all three counts agree.
+ *
+ * @param config The benchmark settings.
+ * @return int 0 if every method found the same hits, 1 otherwise.
+ */
+static int benchCollision(const BenchConfig& config) {
+    int targets = (config.count > 0) ? config.count : 10000;
+    const int queryCount = 64;
+
+    // Scatter sprite-sized boxes over an area that keeps a few hits per query
+    std::mt19937 gen(12345);
+    Fixed side = fromFloat(std::sqrt(static_cast<float>(targets)) * 60.0f);
+    std::uniform_int_distribution<Fixed> coordinate(0, side);
+    std::vector<FixedRect> rects;
+    BoxArray boxes;
+    for (int i = 0; i < targets; ++i) {
+        FixedRect rect{coordinate(gen), coordinate(gen), toFixed(30), toFixed(30)};
+        rects.push_back(rect);
+        boxes.push(rect, i);
+    }
+    std::vector<FixedRect> queries;
+    for (int i = 0; i < queryCount; ++i) {
+        queries.push_back({coordinate(gen), coordinate(gen), toFixed(30), toFixed(30)});
+    }
+
+    // Scalar loop, as every collision check was written before
+    long scalarHits = 0;
+    SteadyClock::time_point start = SteadyClock::now();
+    for (int tick = 0; tick < config.ticks; ++tick) {
+        for (const FixedRect& query : queries) {
+            for (const FixedRect& rect : rects) {
+                scalarHits += query.intersects(rect);
+            }
+        }
+    }
+    double scalarSeconds = std::chrono::duration<double>(SteadyClock::now() - start).count();
+
+    // Hit masks from the batched kernel
+    long maskHits = 0;
+    std::vector<uint64_t> mask(boxes.maskWords());
+    start = SteadyClock::now();
+    for (int tick = 0; tick < config.ticks; ++tick) {
+        for (const FixedRect& query : queries) {
+            boxes.hitMask(query, mask.data());
+            for (uint64_t bits : mask) {
+                for (; bits != 0; bits &= bits - 1) {
+                    maskHits++;
+                }
+            }
+        }
+    }
+    double maskSeconds = std::chrono::duration<double>(SteadyClock::now() - start).count();
+
+    // Repeated first hit scans from the batched kernel
+    long firstHitHits = 0;
+    start = SteadyClock::now();
+    for (int tick = 0; tick < config.ticks; ++tick) {
+        for (const FixedRect& query : queries) {
+            for (size_t i = boxes.firstHit(query); i < boxes.size(); i = boxes.firstHit(query, i + 1)) {
+                firstHitHits++;
+            }
+        }
+    }
+    double firstHitSeconds = std::chrono::duration<double>(SteadyClock::now() - start).count();
+
+    double tests = static_cast<double>(targets) * queryCount * config.ticks / 1e6;
+    printf("collision: %d targets, %d queries, %d ticks, %s kernel\n", targets, queryCount, config.ticks, BoxArray::kernelName());
+    printf("  intersects %10.1f Mtests/s\n", tests / scalarSeconds);
+    printf("  hitMask    %10.1f Mtests/s (%.2fx)\n", tests / maskSeconds, scalarSeconds / maskSeconds);
+    printf("  firstHit   %10.1f Mtests/s (%.2fx)\n", tests / firstHitSeconds, scalarSeconds / firstHitSeconds);
+    bool consistent = scalarHits == maskHits && scalarHits == firstHitHits;
+    printf("  hits %ld %s\n", scalarHits, consistent ? "identical" : "DIFFER");
+    return consistent ? 0 : 1;
+}
+
+/**
+ * @brief Hashes the position of every mushroom.
+ *
+ * @return unsigned long The field hash.
+ */
+static unsigned long hashMushrooms() {
+    unsigned long hash = 1469598103934665603UL;
+    for (const Placement& placement : mushrooms.placements) {
+        FixedVec position = placement.position;
+        hash = (hash ^ static_cast<unsigned long>(position.x)) * 1099511628211UL;
+        hash = (hash ^ static_cast<unsigned long>(position.y)) * 1099511628211UL;
+    }
+    return hash;
+}
+
+/**
+ * @brief Checks that no two mushrooms are closer than a number of cells, counting diagonals as one.
+ *
+ * @param spacing The smallest allowed distance in cells.
+ * @return true if every mushroom keeps the spacing, false otherwise.
+ */
+static bool mushroomsKeepSpacing(int spacing) {
+    int width = getTextureSize(normalMushroomTexture).x;
+    int height = getTextureSize(normalMushroomTexture).y;
+    auto key = [](int column, int row) {return (static_cast<uint64_t>(column) << 32) | static_cast<uint32_t>(row);};
+    std::unordered_set<uint64_t> cells;
+    for (const Placement& placement : mushrooms.placements) {
+        FixedVec position = placement.position;
+        cells.insert(key(toPixels(position.x) / width, toPixels(position.y) / height));
+    }
+    for (uint64_t cell : cells) {
+        int column = static_cast<int>(cell >> 32);
+        int row = static_cast<int>(cell & 0xFFFFFFFF);
+        for (int c = column - spacing + 1; c < column + spacing; ++c) {
+            for (int r = row - spacing + 1; r < row + spacing; ++r) {
+                if ((c != column || r != row) && cells.count(key(c, r))) {
+                    return false;
+                }
+            }
+        }
+    }
+    return true;
+}
+
+/**
+ * @brief Compares the full shuffle mushroom placement against the sampled layouts on a huge field.
+ *
+ * @param config The benchmark settings.
+ * @return int 0 if both sampled layouts are reproducible and the blue-noise one keeps its spacing, 1 otherwise.
+ */
+static int benchMushrooms(const BenchConfig& config) {
+    int count = (config.count > 0) ? config.count : 10000;
+    int repeats = std::max(1, config.ticks / 60);
+    int width = getTextureSize(normalMushroomTexture).x;
+    int height = getTextureSize(normalMushroomTexture).y;
+
+    // Grow the field to the largest square of cells, inside the usual borders, whose pixels fit in fixed point
+    int gridSize = FIXED_MAX_PIXELS / std::max(width, height) - 4;
+    int savedWidth = windowWidth;
+    int savedHeight = windowHeight;
+    windowWidth = (gridSize + 2) * width;
+    windowHeight = (gridSize + 4) * height;
+
+    // Full shuffle of every cell, as fields were generated before
+    SteadyClock::time_point start = SteadyClock::now();
+    for (int repeat = 0; repeat < repeats; ++repeat) {
+        clearMushrooms();
+        std::mt19937 gen(repeat);
+        std::vector<std::pair<int, int>> cells;
+        for (int x = width; x < (windowWidth / width) * width - width; x += width) {
+            for (int y = height; y < (windowHeight / height) * height - height * 3; y += height) {
+                cells.emplace_back(x, y);
+            }
+        }
+        std::shuffle(cells.begin(), cells.end(), gen);
+        for (int i = 0; i < count; ++i) {
+            addMushroom(cells[i].first, cells[i].second);
+        }
+        frameArenaReset();
+    }
+    double shuffleSeconds = std::chrono::duration<double>(SteadyClock::now() - start).count() / repeats;
+
+    // Time each sampled layout and check a second field from the same seed matches
+    auto timeLayout = [&](MushroomLayout layout, unsigned long& hash) {
+        SteadyClock::time_point start = SteadyClock::now();
+        for (int repeat = 0; repeat < repeats; ++repeat) {
+            generateMushrooms(repeat, count, layout);
+            frameArenaReset();
+        }
+        double seconds = std::chrono::duration<double>(SteadyClock::now() - start).count() / repeats;
+        hash = hashMushrooms();
+        generateMushrooms(repeats - 1, count, layout);
+        frameArenaReset();
+        return seconds;
+    };
+    unsigned long uniformHash, blueNoiseHash;
+    double uniformSeconds = timeLayout(MushroomLayout::UNIFORM, uniformHash);
+    bool uniformRepeats = hashMushrooms() == uniformHash;
+    int uniformCount = mushrooms.size();
+    double blueNoiseSeconds = timeLayout(MushroomLayout::BLUE_NOISE, blueNoiseHash);
+    bool blueNoiseRepeats = hashMushrooms() == blueNoiseHash;
+    int blueNoiseCount = mushrooms.size();
+    bool spaced = mushroomsKeepSpacing(2);
+
+    clearMushrooms();
+    windowWidth = savedWidth;
+    windowHeight = savedHeight;
+
+    printf("mushrooms: %d mushrooms on %dx%d cells, %d repeats\n", count, gridSize, gridSize, repeats);
+    printf("  shuffle    %10.3f ms\n", shuffleSeconds * 1000);
+    printf("  uniform    %10.3f ms (%.1fx), %d placed, %s\n", uniformSeconds * 1000, shuffleSeconds / uniformSeconds,
+        uniformCount, uniformRepeats ? "reproducible" : "NOT REPRODUCIBLE");
+    printf("  blue-noise %10.3f ms (%.1fx), %d placed, %s, %s\n", blueNoiseSeconds * 1000, shuffleSeconds / blueNoiseSeconds,
+        blueNoiseCount, blueNoiseRepeats ? "reproducible" : "NOT REPRODUCIBLE", spaced ? "spaced" : "CROWDED");
+    return (uniformRepeats && blueNoiseRepeats && spaced) ? 0 : 1;
+}
+
+/**
+ * @brief Rasterizes one GAME frame into the framebuffer.
+ *
+ * @param fullComposite Whether to recomposite the whole field layer instead of drawing it from the cache.
+ */
+static void renderBenchFrame(bool fullComposite) {
+    if (fullComposite) {
+        invalidateFieldLayer();
+    }
+    framebuffer.clear();
+    drawFieldLayer();
+    centipede.draw();
+    spider.draw();
+    player.draw();
+}
+
+/**
+ * @brief Times software frames of an automated game, the simulation stepped between frames.
+ *
+ * @param frames The number of frames.
+ * @param fullComposite Whether every frame recomposites the whole field layer.
+ * @return double The frames rendered per second, not counting the simulation.
+ */
+static double timeRender(int frames, bool fullComposite) {
+    double seconds = 0;
+    for (int frame = 0; frame < frames; ++frame) {
+        if (stepGame(autoPlayerKeys()).gameOver) {
+            startGame();
+            placeBenchMushrooms();
+        }
+        SteadyClock::time_point start = SteadyClock::now();
+        renderBenchFrame(fullComposite);
+        seconds += std::chrono::duration<double>(SteadyClock::now() - start).count();
+        frameArenaReset();
+        animationAdvance();
+    }
+    return frames / seconds;
+}
+
+/**
+ * @brief Times the software render backend at the window's native size.
+ *
+ * Frames are rendered with the field layer drawn from its cache as in the
+ * game, then recomposited every frame with the SSE2 span kernel and with the
+ * scalar one. The last frame is also rendered with both kernels and checked
+ * to come out pixel for pixel the same.
+ *
+ * @param config The benchmark settings.
+ * @return int 0 if both kernels rendered the same frame, 1 otherwise.
+ */
+static int benchRender(const BenchConfig& config) {
+    int frames = std::max(1, config.ticks);
+    framebuffer.create(windowWidth, windowHeight);
+
+    // The same scaled background the game draws under the mushrooms
+    Texture background;
+    if (!loadTexture(background, "assets/textures/DirtBackground.png")) {
+        printf("Failed to load texture from %s\n", "assets/textures/DirtBackground.png");
+        return 1;
+    }
+    Sprite backgroundSprite;
+    setSpriteTexture(backgroundSprite, background);
+    backgroundSprite.setScale(static_cast<float>(windowWidth) / getTextureSize(background).x, static_cast<float>(windowHeight) / getTextureSize(background).y);
+    fieldLayerInit(backgroundSprite);
+    startGame();
+    placeBenchMushrooms();
+
+    double cachedFps = timeRender(frames, false);
+    double simdFps = timeRender(frames, true);
+    setSimdSpans(false);
+    double scalarFps = timeRender(frames, true);
+
+    // Both kernels must produce the same pixels for the same state
+    renderBenchFrame(true);
+    uint64_t scalarHash = framebuffer.hash();
+    setSimdSpans(true);
+    renderBenchFrame(true);
+    uint64_t simdHash = framebuffer.hash();
+
+    printf("render: %dx%d software frames, %d frames per run\n", windowWidth, windowHeight, frames);
+    printf("  cached layer          %10.1f frames/s\n", cachedFps);
+    printf("  full composite SSE2   %10.1f frames/s\n", simdFps);
+    printf("  full composite scalar %10.1f frames/s (SSE2 %.2fx)\n", scalarFps, simdFps / scalarFps);
+    printf("  kernels %s\n", (simdHash == scalarHash) ? "identical" : "DIFFER");
+    return (simdHash == scalarHash) ? 0 : 1;
+}
+
+int runBench(const BenchConfig& config) {
+    if (config.name == "collision") {
+        return benchCollision(config);
+    }
+
+    // Nothing is shown, so keep every texture on the CPU
+    setRenderBackend(RenderBackend::SOFTWARE);
+    initGameElements();
+    if (config.name == "heads") {
+        return benchHeads(config);
+    }
+    if (config.name == "mushrooms") {
+        return benchMushrooms(config);
+    }
+    if (config.name == "render") {
+        return benchRender(config);
+    }
+    printf("Unknown benchmark %s\n", config.name.c_str());
+    return 1;
+}
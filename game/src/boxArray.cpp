@@ -0,0 +1,168 @@
+#include "boxArray.h"
+#include <atomic>
+#include <limits>
+#include <memory>
+#include <mutex>
+#include <vector>
+
+#if defined(__AVX2__)
+#include <immintrin.h>
+#define BOXARRAY_AVX2
+#elif defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#include <emmintrin.h>
+#define BOXARRAY_SSE2
+#endif
+
+/**
+ * @struct TestCounter
+ * @brief The box tests performed on one thread, on a cache line of its own.
+ *
+ * Only its thread writes it, so counting needs no read-modify-write shared
+ * between threads. The atomic only lets getTestCount() read it meanwhile.
+ */
+struct alignas(64) TestCounter {
+    std::atomic<uint64_t> tests{0}; ///< The box tests counted so far.
+};
+
+static std::atomic<bool> countingTests{false}; ///< Whether queries count their box tests.
+static std::mutex countersMutex; ///< Guards counters.
+static std::vector<std::unique_ptr<TestCounter>> counters; ///< One counter per thread that ever counted, kept after the thread exits.
+
+/**
+ * @brief Adds box tests to the counter of the calling thread, registering it on first use.
+ *
+ * @param tests The number of box tests.
+ */
+static void countTests(uint64_t tests) {
+    if (!countingTests.load(std::memory_order_relaxed)) {
+        return;
+    }
+    thread_local TestCounter* counter = nullptr;
+    if (!counter) {
+        std::lock_guard<std::mutex> lock(countersMutex);
+        counters.push_back(std::make_unique<TestCounter>());
+        counter = counters.back().get();
+    }
+    counter->tests.store(counter->tests.load(std::memory_order_relaxed) + tests, std::memory_order_relaxed);
+}
+
+void BoxArray::clear() {
+    lefts.clear();
+    tops.clear();
+    rights.clear();
+    bottoms.clear();
+    ids.clear();
+    count = 0;
+}
+
+void BoxArray::push(const FixedRect& box, uint32_t id) {
+    // Grow a whole block at a time, padding with inverted boxes that can never intersect
+    if (count == lefts.size()) {
+        Fixed largest = std::numeric_limits<Fixed>::max();
+        Fixed smallest = std::numeric_limits<Fixed>::min();
+        lefts.resize(count + blockSize, largest);
+        tops.resize(count + blockSize, largest);
+        rights.resize(count + blockSize, smallest);
+        bottoms.resize(count + blockSize, smallest);
+        ids.resize(count + blockSize, 0);
+    }
+    lefts[count] = box.left;
+    tops[count] = box.top;
+    rights[count] = box.left + box.width;
+    bottoms[count] = box.top + box.height;
+    ids[count] = id;
+    count++;
+}
+
+uint32_t BoxArray::testBlock(const Fixed* query, size_t block) const {
+#if defined(BOXARRAY_AVX2)
+    auto load = [](const std::vector<Fixed>& edges, size_t i) {return _mm256_loadu_si256(reinterpret_cast<const __m256i*>(&edges[i]));};
+    __m256i hit = _mm256_and_si256(
+        _mm256_and_si256(_mm256_cmpgt_epi32(load(rights, block), _mm256_set1_epi32(query[0])),
+                         _mm256_cmpgt_epi32(_mm256_set1_epi32(query[2]), load(lefts, block))),
+        _mm256_and_si256(_mm256_cmpgt_epi32(load(bottoms, block), _mm256_set1_epi32(query[1])),
+                         _mm256_cmpgt_epi32(_mm256_set1_epi32(query[3]), load(tops, block))));
+    return static_cast<uint32_t>(_mm256_movemask_ps(_mm256_castsi256_ps(hit)));
+#elif defined(BOXARRAY_SSE2)
+    auto load = [](const std::vector<Fixed>& edges, size_t i) {return _mm_loadu_si128(reinterpret_cast<const __m128i*>(&edges[i]));};
+    uint32_t bits = 0;
+    for (size_t half = 0; half < blockSize; half += 4) {
+        size_t i = block + half;
+        __m128i hit = _mm_and_si128(
+            _mm_and_si128(_mm_cmpgt_epi32(load(rights, i), _mm_set1_epi32(query[0])),
+                          _mm_cmpgt_epi32(_mm_set1_epi32(query[2]), load(lefts, i))),
+            _mm_and_si128(_mm_cmpgt_epi32(load(bottoms, i), _mm_set1_epi32(query[1])),
+                          _mm_cmpgt_epi32(_mm_set1_epi32(query[3]), load(tops, i))));
+        bits |= static_cast<uint32_t>(_mm_movemask_ps(_mm_castsi128_ps(hit))) << half;
+    }
+    return bits;
+#else
+    uint32_t bits = 0;
+    for (size_t lane = 0; lane < blockSize; ++lane) {
+        size_t i = block + lane;
+        bits |= static_cast<uint32_t>(query[0] < rights[i] & lefts[i] < query[2] & query[1] < bottoms[i] & tops[i] < query[3]) << lane;
+    }
+    return bits;
+#endif
+}
+
+size_t BoxArray::firstHit(const FixedRect& query, size_t start) const {
+    const Fixed edges[4] = {query.left, query.top, query.left + query.width, query.top + query.height};
+
+    // Mask off the boxes before start in the first block
+    size_t first = start - start % blockSize;
+    uint32_t skip = ~0u << (start % blockSize);
+    for (size_t block = first; block < count; block += blockSize) {
+        uint32_t bits = testBlock(edges, block) & skip;
+        if (bits != 0) {
+            countTests(block + blockSize - first);
+            size_t index = block;
+            while ((bits & 1) == 0) {
+                bits >>= 1;
+                index++;
+            }
+            return index;
+        }
+        skip = ~0u;
+    }
+    if (count > first) {
+        countTests(lefts.size() - first);
+    }
+    return count;
+}
+
+void BoxArray::hitMask(const FixedRect& query, uint64_t* mask) const {
+    const Fixed edges[4] = {query.left, query.top, query.left + query.width, query.top + query.height};
+    for (size_t word = 0; word < maskWords(); ++word) {
+        mask[word] = 0;
+    }
+
+    // Padding never intersects, so whole blocks can be written without masking
+    for (size_t block = 0; block < count; block += blockSize) {
+        mask[block / 64] |= static_cast<uint64_t>(testBlock(edges, block)) << (block % 64);
+    }
+    countTests(lefts.size());
+}
+
+void BoxArray::setTestCounting(bool counting) {
+    countingTests.store(counting, std::memory_order_relaxed);
+}
+
+uint64_t BoxArray::getTestCount() {
+    std::lock_guard<std::mutex> lock(countersMutex);
+    uint64_t total = 0;
+    for (const std::unique_ptr<TestCounter>& counter : counters) {
+        total += counter->tests.load(std::memory_order_relaxed);
+    }
+    return total;
+}
+
+const char* BoxArray::kernelName() {
+#if defined(BOXARRAY_AVX2)
+    return "avx2";
+#elif defined(BOXARRAY_SSE2)
+    return "sse2";
+#else
+    return "scalar";
+#endif
+}
@@ -1,144 +1,148 @@
 #include "centipede.h"
+#include <mutex>
+#include "animation.h"
+#include "memoryTracker.h"
+#include "parallel.h"
+#include "renderBackend.h"
 
 std::vector<Texture> headTextures, bodyTextures;
 ECE_Centipede centipede(0, 0);
 
-int getSign(float value) {
-    if (value > 0) {
-        return 1;
-    } else if (value < 0) {
-        return -1;
-    } else {
-        return 0;
-    }
-}
+static std::mutex segmentBoxesMutex; ///< Serializes rebuilds of the segment boxes by concurrent readers.
 
 void centipedeInit(int length, int initialSpeed) {
-    // Load head textures
+    MemoryScope scope(Subsystem::TEXTURES);
+
+    // Load head textures in place, they must not move once loaded
     std::vector<std::string> headFileNames = {"assets/textures/CentipedeHead0.png", "assets/textures/CentipedeHead1.png", "assets/textures/CentipedeHead2.png"};
-    for (const auto& fileName : headFileNames) {
-        Texture texture;
-        if (!texture.loadFromFile(fileName)) {
-            printf("Failed to load texture from %s\n", fileName.c_str());
+    headTextures = std::vector<Texture>(headFileNames.size());
+    for (size_t i = 0; i < headFileNames.size(); i++) {
+        if (!loadTexture(headTextures[i], headFileNames[i])) {
+            printf("Failed to load texture from %s\n", headFileNames[i].c_str());
         }
-        headTextures.push_back(texture);
     }
 
     // Load body textures
     std::vector<std::string> bodyFileNames = {"assets/textures/CentipedeBody0.png", "assets/textures/CentipedeBody1.png", "assets/textures/CentipedeBody2.png"};
-    for (const auto& fileName : bodyFileNames) {
-        Texture texture;
-        if (!texture.loadFromFile(fileName)) {
-            printf("Failed to load texture from %s\n", fileName.c_str());
+    bodyTextures = std::vector<Texture>(bodyFileNames.size());
+    for (size_t i = 0; i < bodyFileNames.size(); i++) {
+        if (!loadTexture(bodyTextures[i], bodyFileNames[i])) {
+            printf("Failed to load texture from %s\n", bodyFileNames[i].c_str());
         }
-        bodyTextures.push_back(texture);
     }
 
     // Initialize the centipede
+    MemoryScope centipedeScope(Subsystem::CENTIPEDE);
     centipede = ECE_Centipede(length, initialSpeed);
 }
 
-ECE_CentipedeSegment::ECE_CentipedeSegment(bool isHead, int initialSpeed) {
-    dx = 1;
-    dy = 1;
-    savedDy = 0;
-    randomWalkDy = 0;
-    speed = initialSpeed;
-    delayTicks = 0;
-    this->id = globalCounter++;
-    animationTick = 0;
-    textureIndex = 0;
-    setType((isHead) ? SegmentType::HEAD : SegmentType::BODY);
-    setTexture((isHead) ? headTextures[textureIndex] : bodyTextures[textureIndex]);
-    setStatus(CharacterStatus::ALIVE);
-    maxDelayTicks = getGlobalBounds().width / speed;
-    // Fill the moves queue with default moves to match the delay ticks
-    for (int i = 0; i < maxDelayTicks; i++) {
-        moves.push(std::make_tuple(windowWidth / 2.0f, 0.0f, dx, dy));
+void MoveQueue::push(const Move& move) {
+    if (count == ring.size()) {
+        reserve(std::max<size_t>(2 * ring.size(), 1));
     }
+    ring[(head + count) % ring.size()] = move;
+    count++;
 }
 
-bool inSegmentList(std::list<ECE_CentipedeSegment> list, ECE_CentipedeSegment segment) {
-    return std::find(list.begin(), list.end(), segment) != list.end();
+void MoveQueue::reserve(size_t capacity) {
+    if (capacity <= ring.size()) {
+        return;
+    }
+    // Unwrap the queued moves to the start of the larger ring
+    std::vector<Move> grown(capacity);
+    for (size_t i = 0; i < count; i++) {
+        grown[i] = ring[(head + i) % ring.size()];
+    }
+    ring.swap(grown);
+    head = 0;
 }
 
-void ECE_CentipedeSegment::animate() {
-    if (animationTick % 15 == 0) {
-        textureIndex = (textureIndex + 1) % ((type == SegmentType::HEAD) ? headTextures.size() : bodyTextures.size());
-        setTexture((type == SegmentType::HEAD) ? headTextures[textureIndex] : bodyTextures[textureIndex]);
-    }
-    animationTick++;
+/**
+ * @struct ECE_Centipede::SegmentView
+ * @brief The components one segment moves with, looked up once per move.
+ */
+struct ECE_Centipede::SegmentView {
+    uint32_t index; ///< The entity index of the segment.
+    Placement& placement; ///< Where the segment is.
+    const Collider& collider; ///< The size of the segment.
+    Motion& motion; ///< The direction and speed of the segment.
+    SegmentState& state; ///< The rest of the segment's AI state.
+
+    /**
+     * @brief Returns the segment's collision box.
+     *
+     * @return FixedRect The collision box.
+     */
+    FixedRect bounds() const {return collider.bounds(placement);};
+};
+
+ECE_Centipede::SegmentView ECE_Centipede::viewSegment(uint32_t index) {
+    Entity entity = segments.entityAt(index);
+    return {index, *segments.placements.get(entity), *segments.colliders.get(entity), *segments.motions.get(entity), *segmentStates.get(entity)};
 }
 
-std::list<ECE_CentipedeSegment> ECE_CentipedeSegment::getTrailingBodies(ECE_CentipedeSegment& segment) {
-    // Find the current segment in the centipede
-    auto it = std::find(centipede.getSegments().begin(), centipede.getSegments().end(), segment);
-    if (it == centipede.getSegments().end()) {
-        // No trailing bodies if the segment is last
-        return {};
-    } else {
-        // Find all consecutive living trailing bodies
-        std::list<ECE_CentipedeSegment> trailingBodies;
-        for (++it; it != centipede.getSegments().end(); ++it) {
-            if (it->getType() == SegmentType::BODY && it->getStatus() == CharacterStatus::ALIVE) {
-                trailingBodies.push_back(*it);
-            } else {
-                break;
-            }
-        }
-        return trailingBodies;
+uint32_t ECE_Centipede::getTrailingEnd(uint32_t index) {
+    // Find all consecutive living trailing bodies in the entity indices after this segment
+    uint32_t end = index + 1;
+    Entity next = segments.entityAt(end);
+    while (isLiving(next) && segmentStates.get(next)->type == SegmentType::BODY) {
+        next = segments.entityAt(++end);
     }
+    return end;
 }
 
-void ECE_CentipedeSegment::checkCollisions() {
-    float playerY = player.getPosition().y;
-
-    // Check for collisions with mushrooms
-    for (Mushroom& mushroom : mushrooms) {
-        if (mushroom.getHealth() > 0 && getGlobalBounds().intersects(mushroom.getGlobalBounds())) {
-            // Teleport head to the closest open spot if it is stuck in a mushroom
-            Vector2f newPosition = findClosestOpenSpot();
-            setPosition(newPosition);
-            break;
-        }
-        if (mushroom.getHealth() > 0 && getNextSegmentBounds().intersects(mushroom.getGlobalBounds())) {
-            // Reverse direction if it is going to collide with a mushroom
-            dx = -dx;
-            dy = (centipede.getRandomWalk()) ? randomWalkDy : getSign(playerY - getPosition().y);
-            break;
-        }
+template <typename Playfield>
+void ECE_Centipede::checkCollisions(SegmentView& segment, const Playfield& field) {
+    int& dx = segment.motion.dx;
+    int& dy = segment.motion.dy;
+    int& savedDy = segment.state.savedDy;
+    int& randomWalkDy = segment.state.randomWalkDy;
+    Fixed playerY = player.getFixedPosition().y;
+    FixedVec position = segment.placement.position;
+
+    // Step along the flow field towards the player, or straight at the player row where it has no preference
+    auto towardPlayer = [&]() {
+        int step = flowField.verticalStep(position, dx);
+        return (step != 0) ? step : getSign(playerY - position.y);
+    };
+    FixedRect bounds = segment.bounds();
+    Fixed step = segment.motion.speed;
+
+    // Check for collisions with mushrooms, the first mushroom touching either bounds deciding
+    const BoxArray& mushroomBoxes = getMushroomBoxes();
+    size_t stuckIn = mushroomBoxes.firstHit(bounds);
+    size_t blockedBy = mushroomBoxes.firstHit(getNextSegmentBounds(segment));
+    if (stuckIn < mushroomBoxes.size() && stuckIn <= blockedBy) {
+        // Teleport head to the closest open spot if it is stuck in a mushroom
+        position = findClosestOpenSpot(segment, field);
+        segment.placement.position = position;
+    } else if (blockedBy < mushroomBoxes.size()) {
+        // Reverse direction if it is going to collide with a mushroom
+        dx = -dx;
+        dy = (randomWalk) ? randomWalkDy : towardPlayer();
     }
 
-    // Check for collisions with other centipede segments that are not in the trailing bodies
-    std::list<ECE_CentipedeSegment> trailingBodies = getTrailingBodies(*this);
-    for (ECE_CentipedeSegment& segment : centipede.getSegments()) {
-        // Cases to skip: same segment, dead segment, or segment in trailing bodies
-        if (getId() == segment.getId() || segment.getStatus() == CharacterStatus::DEAD || inSegmentList(trailingBodies, segment)) {
-            continue;
-        }
-        
-        // Check for collisions with other segments and reverse direction if needed
-        if (getNextSegmentBounds().intersects(segment.getGlobalBounds())) {
-            dx = -dx;
-            dy = (centipede.getRandomWalk()) ? randomWalkDy : getSign(playerY - getPosition().y);
-            break;
-        }
+    // Check for collisions with other living centipede segments that are not in the trailing bodies
+    uint32_t trailingEnd = getTrailingEnd(segment.index);
+    if (hitsOtherSegment(segment.index, getNextSegmentBounds(segment), trailingEnd)) {
+        dx = -dx;
+        dy = (randomWalk) ? randomWalkDy : towardPlayer();
     }
 
     // Check for collisions with the horizontal window boundaries
-    if (getPosition().x + dx * speed < 0 || getPosition().x + dx * speed + getGlobalBounds().width > windowWidth) {
-        dx = getSign(0.5 * windowWidth - getPosition().x);
-        dy = (centipede.getRandomWalk()) ? randomWalkDy : getSign(playerY - getPosition().y);
+    if (position.x + dx * step < 0 || position.x + dx * step + bounds.width > field.width) {
+        dx = getSign(field.width / 2 - position.x);
+        dy = (randomWalk) ? randomWalkDy : towardPlayer();
     }
 
-    // Check for collisions with the vertical window boundaries
-    if (getPosition().y + dy * speed < 0 || getPosition().y + dy * speed + getGlobalBounds().height > static_cast<int>(windowHeight / getGlobalBounds().height) * getGlobalBounds().height) {
-        dy = (centipede.getRandomWalk()) ? getSign(0.5 * windowHeight - getPosition().y) : getSign(playerY - getPosition().y);
-        if (centipede.getRandomWalk()) randomWalkDy = dy;
+    // Check for collisions with the vertical window boundaries, the bottom being the last whole grid row
+    if (position.y + dy * step < 0 || position.y + dy * step + bounds.height > field.gridBottom) {
+        dy = (randomWalk) ? getSign(field.height / 2 - position.y) : towardPlayer();
+        if (randomWalk) randomWalkDy = dy;
     }
 
     // Check if movement in current dx, dy is possible
-    if (!segmentCanMove(getNextSegmentBounds((dy != 0) ? 0 : dx, dy))) {
+    if (!segmentCanMove(segment.index, getNextSegmentBounds(segment, (dy != 0) ? 0 : dx, dy))) {
         // Save dy if vertical movement is blocked and try horizontal movement
         if (dy != 0) {
             savedDy = dy;
@@ -146,7 +150,7 @@ void ECE_CentipedeSegment::checkCollisions() {
         }
 
         // Check if horizontal movement is possible
-        if (!segmentCanMove(getNextSegmentBounds(dx, 0))) {
+        if (!segmentCanMove(segment.index, getNextSegmentBounds(segment, dx, 0))) {
             // Try other direction if horizontal movement is blocked
             dx = -dx;
         }
@@ -154,118 +158,113 @@ void ECE_CentipedeSegment::checkCollisions() {
 
     // If savedDy is non-zero, try overriding dy to savedDy once vertical movement is possible
     if (savedDy != 0) {
-        if (segmentCanMove(getNextSegmentBounds(0, savedDy))) {
+        if (segmentCanMove(segment.index, getNextSegmentBounds(segment, 0, savedDy))) {
             dy = savedDy;
             savedDy = 0;
         }
     }
 }
 
-bool ECE_CentipedeSegment::segmentCanMove(FloatRect bounds) {
-    std::list<ECE_CentipedeSegment> trailingBodies = getTrailingBodies(*this);
-    for (auto& segment : centipede.getSegments()) {
-        // Only account for living segments that are not in the trailing bodies
-        if (getId() != segment.getId() && segment.getStatus() == CharacterStatus::ALIVE && bounds.intersects(segment.getGlobalBounds()) && !inSegmentList(trailingBodies, segment)) {
-            return false;
-        }
+bool ECE_Centipede::segmentCanMove(uint32_t index, FixedRect bounds) {
+    // Only account for living segments that are not in the trailing bodies
+    if (hitsOtherSegment(index, bounds, getTrailingEnd(index))) {
+        return false;
     }
 
     // Check for collisions with mushrooms
-    for (auto& mushroom : mushrooms) {
-        if (mushroom.getHealth() > 0 && bounds.intersects(mushroom.getGlobalBounds())) {
-            return false;
+    const BoxArray& mushroomBoxes = getMushroomBoxes();
+    return mushroomBoxes.firstHit(bounds) == mushroomBoxes.size();
+}
+
+bool ECE_Centipede::hitsOtherSegment(uint32_t index, const FixedRect& bounds, uint32_t trailingEnd) {
+    for (size_t i = occupancy.firstHit(bounds); i < occupancy.size(); i = occupancy.firstHit(bounds, i + 1)) {
+        // Cases to skip: same segment or segment in trailing bodies
+        uint32_t other = occupancy.getId(i);
+        if (other != index && (other < index || other >= trailingEnd)) {
+            return true;
         }
     }
-    return true;
+    return false;
 }
 
-void ECE_CentipedeSegment::headMove() {
-    int currentY = getPosition().y;
-    int nextY = currentY + dy * speed;
-    int size = getGlobalBounds().height;
-    
+template <typename Playfield>
+void ECE_Centipede::headMove(SegmentView& segment, const Playfield& field) {
+    int& dx = segment.motion.dx;
+    int& dy = segment.motion.dy;
+    Fixed speed = segment.motion.speed;
+    FixedVec& position = segment.placement.position;
+    Fixed currentY = position.y;
+    Fixed nextY = currentY + dy * speed;
+
     if (dy != 0) {
         // Moving vertically
         if (dy > 0) {
             // Moving down
-            if (nextY % size == 0 || (currentY / size < nextY / size) && currentY % size != 0) {
+            if (field.isAligned(nextY) || (field.cellIndex(currentY) < field.cellIndex(nextY)) && !field.isAligned(currentY)) {
                 // Stop moving vertically if the next position is aligned to the grid
-                int roundedY = (nextY / size) * size;
-                setPosition(getPosition().x, roundedY);
+                Fixed roundedY = field.snap(nextY);
+                position.y = roundedY;
                 dy = 0;
             } else {
                 // Continue moving vertically
-                setPosition(getPosition().x, nextY);
+                position.y = nextY;
             }
         } else if (dy < 0) {
             // Moving up
-            if (nextY % size == 0 || (currentY / size > nextY / size) && currentY % size != 0) {
+            if (field.isAligned(nextY) || (field.cellIndex(currentY) > field.cellIndex(nextY)) && !field.isAligned(currentY)) {
                 // Stop moving vertically if the next position is aligned to the grid
-                int roundedY = (currentY / size) * size;
-                setPosition(getPosition().x, roundedY);
+                Fixed roundedY = field.snap(currentY);
+                position.y = roundedY;
                 dy = 0;
             } else {
                 // Continue moving vertically
-                setPosition(getPosition().x, nextY);
+                position.y = nextY;
             }
         }
     } else {
         // Moving horizontally
-        setPosition(getPosition().x + dx * speed, getPosition().y);
+        position.x += dx * speed;
     }
 
     // Update texture orientation based on the current direction
-    updateTextureOrientation();
+    updateFacing(segment);
 }
 
-void ECE_CentipedeSegment::bodyMove(int dx, int dy, float x, float y) {
+
+void ECE_Centipede::bodyMove(SegmentView& segment, int dx, int dy, FixedVec position) {
     // Prioritize vertical movement
-    moves.push(std::make_tuple(x, y, dx, dy));
+    MoveQueue& moves = segment.state.moves;
+    moves.push(std::make_tuple(position.x, position.y, dx, dy));
     auto [nextX, nextY, nextDx, nextDy] = moves.front();
     moves.pop();
-    setPosition(nextX, nextY);
-    this->dx = nextDx;
-    this->dy = nextDy;
+    segment.placement.position = {nextX, nextY};
+    segment.motion.dx = nextDx;
+    segment.motion.dy = nextDy;
 
     // Update texture orientation based on the current direction
-    updateTextureOrientation();
+    updateFacing(segment);
 }
 
-FloatRect ECE_CentipedeSegment::getNextSegmentBounds(int useDx, int useDy) {
-    FloatRect bounds = getGlobalBounds();
-    int dx = (useDx == 999) ? this->dx : useDx;
-    int dy = (useDy == 999) ? this->dy : useDy;
-    bounds.left += dx * speed;
-    bounds.top += dy * speed;
+FixedRect ECE_Centipede::getNextSegmentBounds(const SegmentView& segment, int useDx, int useDy) {
+    FixedRect bounds = segment.bounds();
+    int dx = (useDx == 999) ? segment.motion.dx : useDx;
+    int dy = (useDy == 999) ? segment.motion.dy : useDy;
+    bounds.left += dx * segment.motion.speed;
+    bounds.top += dy * segment.motion.speed;
     return bounds;
 }
 
-void ECE_CentipedeSegment::updateTextureOrientation() {
-    FloatRect bounds = getLocalBounds();
-    float originX = 0;
-    float originY = 0;
-
-    // Determine rotation and scale for texture orientation
-    float rotation = 0.0f;
-    Vector2f scale(1.0f, 1.0f);
-
+void ECE_Centipede::updateFacing(SegmentView& segment) {
+    // Vertical movement takes priority over horizontal movement
+    int dx = segment.motion.dx;
+    int dy = segment.motion.dy;
     if (dy != 0) {
-        // Vertical movement: rotate texture
-        rotation = (dy > 0) ? 90.0f : -90.0f; // Down: 90 degrees, Up: -90 degrees
-        originX = (dy > 0) ? 0.0f : bounds.width;
-        originY = (dy > 0) ? bounds.height : 0.0f;
+        segment.state.facing = (dy > 0) ? Orientation::DOWN : Orientation::UP;
     } else if (dx != 0) {
-        // Horizontal movement: flip texture horizontally if moving left
-        scale.x = (dx < 0) ? -1.0f : 1.0f;
-        originX = (dx < 0) ? bounds.width : 0.0f;
+        segment.state.facing = (dx > 0) ? Orientation::RIGHT : Orientation::LEFT;
+    } else {
+        segment.state.facing = Orientation::NONE;
     }
-
-    // Apply rotation and scale
-    setRotation(rotation);
-    setScale(scale);
-
-    // Reset origin so that the texture stays centered
-    setOrigin(originX, originY);
 }
 
 ECE_Centipede::ECE_Centipede(int segmentCount, int initialSpeed) {
@@ -274,153 +273,233 @@ ECE_Centipede::ECE_Centipede(int segmentCount, int initialSpeed) {
     speed = initialSpeed;
     randomWalk = false;
     
-    // Initialize the first segment as the head
+    spawnSegments(initialSpeed);
+}
+
+void ECE_Centipede::spawnSegments(int segmentSpeed) {
+    MemoryScope scope(Subsystem::CENTIPEDE);
+    heads.clear();
+    liveCount = length;
+    segmentBoxesStale = true;
+    // Create the first segment as the head, entity indices are handed out in chain order after a clear
     for (int i = 0; i < length; i++) {
-        ECE_CentipedeSegment segment(i == 0, initialSpeed);
-        segment.setPosition((windowWidth / 2), 0);
-        segments.push_back(segment);
+        bool isHead = i == 0;
+        const std::vector<Texture>& frames = (isHead) ? headTextures : bodyTextures;
+        Vector2u size = getTextureSize(frames[0]);
+        Entity segment = segments.create();
+        segments.placements.insert(segment, {{toFixed(windowWidth / 2), 0}});
+        segments.colliders.insert(segment, {toFixed(size.x), toFixed(size.y)});
+        segments.healths.insert(segment, {1});
+        segments.renderables.insert(segment, {&frames[0]});
+        segments.animations.insert(segment, {&frames, 15, animationTick});
+        segments.motions.insert(segment, {1, 1, toFixed(segmentSpeed)});
+
+        // Fill the moves queue in place with default moves to match the delay ticks, leaving room for the next push
+        segmentStates.insert(segment, {(isHead) ? SegmentType::HEAD : SegmentType::BODY});
+        SegmentState& state = *segmentStates.get(segment);
+        state.maxDelayTicks = static_cast<int>(size.x) / segmentSpeed;
+        state.moves.reserve(state.maxDelayTicks + 1);
+        for (int j = 0; j < state.maxDelayTicks; j++) {
+            state.moves.push(std::make_tuple(toFixed(windowWidth) / 2, 0, 1, 1));
+        }
+        if (isHead) heads.push_back(segment.index);
     }
 }
 
 void ECE_Centipede::setRandomWalk(bool randomWalk) {
     this->randomWalk = randomWalk;
-    if (randomWalk) segments.front().setRandomWalkDy(1);
-    else segments.front().setRandomWalkDy(0);
+    SegmentState* first = segmentStates.get(segments.entityAt(0));
+    if (!first) return;
+    first->randomWalkDy = (randomWalk) ? 1 : 0;
 }
 
 void ECE_Centipede::setSpeed(int speed) {
     this->speed = speed;
-    for (auto& segment : centipede.getSegments()) {
-        segment.setSpeed(speed);
-        segment.setMaxDelayTicks(segment.getGlobalBounds().width / speed);
-        while (segment.getMoves().size() > segment.getMaxDelayTicks()) {
-            segment.getMoves().pop();
+    for (size_t i = 0; i < segmentStates.size(); i++) {
+        Entity segment = segmentStates.entityAt(i);
+        SegmentState& state = segmentStates[i];
+        segments.motions.get(segment)->speed = toFixed(speed);
+        state.maxDelayTicks = toPixels(segments.colliders.get(segment)->width) / speed;
+        while (state.moves.size() > static_cast<size_t>(state.maxDelayTicks)) {
+            state.moves.pop();
         }
     }
 }
 
 void ECE_Centipede::move() {
-    // Iterator to traverse the list of segments
-    auto it = segments.begin();
-    
-    // Initialize saved values
-    int savedDx = 0;
-    int savedDy = 0;
-    float savedX = 0;
-    float savedY = 0;
-
-    // Move each segment in the centipede
-    while (it != segments.end()) {
-        ECE_CentipedeSegment& currentSegment = *it;
-
-        // Check if the current segment is a head
-        if (currentSegment.getType() == SegmentType::HEAD && currentSegment.getStatus() == CharacterStatus::ALIVE) {
-            // Determine the next move for the head
-            currentSegment.checkCollisions();
-            currentSegment.headMove();
-
-            // Save the head's direction and position
-            auto [x, y] = currentSegment.getPosition();
-            auto [dx, dy] = currentSegment.getDirection();
-            savedDx = dx;
-            savedDy = dy;
-            savedX = x;
-            savedY = y;
-        } else if (currentSegment.getStatus() == CharacterStatus::ALIVE) {
-            // Move the body segment using the saved direction and position of previous segment
-            currentSegment.bodyMove(savedDx, savedDy, savedX, savedY);
+    MemoryScope scope(Subsystem::CENTIPEDE);
+
+    // Snapshot the bounds of every living segment and the position of every head
+    occupancy.clear();
+    headPositions.clear();
+    for (uint32_t head : heads) {
+        uint32_t end = getTrailingEnd(head);
+        for (uint32_t i = head; i < end; i++) {
+            occupancy.push(segments.getBounds(segments.entityAt(i)), i);
+        }
+        headPositions.push_back(segments.placements.get(segments.entityAt(head))->position);
+    }
+
+    // Bring the mushroom boxes up to date before the heads share them
+    getMushroomBoxes();
+    segmentBoxesStale = true;
+
+    // Let every head decide and take its move against the snapshot, each head only writes its own components
+    if (heads.empty()) {
+        return;
+    }
+    withPlayfield(segments.getBounds(segments.entityAt(heads[0])).height, [this](const auto& field) {
+        if (!randomWalk) {
+            flowField.update(field.cellIndex(field.gridRight), field.cellIndex(field.gridBottom), field.cell,
+                field.cellIndex(player.getFixedPosition().y), getMushroomBoxes(), getMushroomBoxesVersion());
+        }
+        auto moveHead = [this, &field](size_t i) {
+            SegmentView headSegment = viewSegment(heads[i]);
+            checkCollisions(headSegment, field);
+            headMove(headSegment, field);
+        };
+        if (parallelHeadThreshold > 0 && heads.size() >= parallelHeadThreshold) {
+            parallelFor(heads.size(), moveHead);
+        } else {
+            for (size_t i = 0; i < heads.size(); i++) {
+                moveHead(i);
+            }
+        }
+    });
+
+    // Commit the moves in chain order, sending back any head that moved into a head committed before it
+    for (size_t i = 0; i < heads.size(); i++) {
+        SegmentView headSegment = viewSegment(heads[i]);
+        for (size_t j = 0; j < i; j++) {
+            if (headSegment.bounds().intersects(segments.getBounds(segments.entityAt(heads[j])))) {
+                headSegment.placement.position = headPositions[i];
+                headSegment.motion.dx = -headSegment.motion.dx;
+                updateFacing(headSegment);
+                break;
+            }
+        }
+    }
+
+    // Move the trailing bodies of each chain using the saved direction and position of the previous segment
+    for (uint32_t head : heads) {
+        SegmentView headSegment = viewSegment(head);
+        int savedDx = headSegment.motion.dx;
+        int savedDy = headSegment.motion.dy;
+        FixedVec savedPosition = headSegment.placement.position;
+
+        uint32_t end = getTrailingEnd(head);
+        for (uint32_t i = head + 1; i < end; i++) {
+            SegmentView currentSegment = viewSegment(i);
+            bodyMove(currentSegment, savedDx, savedDy, savedPosition);
 
             // Update saved values to the current segment's new direction and position
-            auto [dx, dy] = currentSegment.getDirection();
-            auto [x, y] = currentSegment.getPosition();
-            savedDx = dx;
-            savedDy = dy;
-            savedX = x;
-            savedY = y;
+            savedDx = currentSegment.motion.dx;
+            savedDy = currentSegment.motion.dy;
+            savedPosition = currentSegment.placement.position;
         }
+    }
+}
 
-        ++it;
+const BoxArray& ECE_Centipede::getSegmentBoxes() {
+    std::lock_guard<std::mutex> lock(segmentBoxesMutex);
+    if (segmentBoxesStale) {
+        MemoryScope scope(Subsystem::CENTIPEDE);
+        segmentBoxes.clear();
+        for (uint32_t head : heads) {
+            uint32_t end = getTrailingEnd(head);
+            for (uint32_t i = head; i < end; i++) {
+                segmentBoxes.push(segments.getBounds(segments.entityAt(i)), i);
+            }
+        }
+        segmentBoxesStale = false;
     }
+    return segmentBoxes;
 }
 
-Vector2f ECE_CentipedeSegment::findClosestOpenSpot() {
-    auto openSpots = findOpenSpots();
+void ECE_Centipede::killSegment(Entity segment) {
+    segments.healths.get(segment)->hitPoints = 0;
+    liveCount--;
+    segmentBoxesStale = true;
 
-    Vector2f currentPosition = getPosition();
-    
-    if (openSpots.empty()) {
-        return currentPosition;
+    // A dead head no longer leads a chain
+    uint32_t index = segment.index;
+    auto it = std::lower_bound(heads.begin(), heads.end(), index);
+    if (it != heads.end() && *it == index) {
+        it = heads.erase(it);
     }
-    
-    // Find the closest open spot
-    Vector2f closestSpot = openSpots.front();
-    float minDistance = std::numeric_limits<float>::max();
-    
-    for (const auto& spot : openSpots) {
-        float distance = std::sqrt(std::pow(spot.x - currentPosition.x, 2) + std::pow(spot.y - currentPosition.y, 2));
-        if (distance < minDistance) {
-            minDistance = distance;
-            closestSpot = spot;
+
+    // Check if the next segment exists and is alive before changing it to a head, keeping its animation phase
+    Entity next = segments.entityAt(index + 1);
+    if (isLiving(next)) {
+        segmentStates.get(next)->type = SegmentType::HEAD;
+        segments.animations.get(next)->frames = &headTextures;
+        if (it == heads.end() || *it != index + 1) {
+            heads.insert(it, index + 1);
         }
     }
-    
-    return closestSpot;
 }
 
-std::vector<Vector2f> ECE_CentipedeSegment::findOpenSpots() {
-    std::vector<Vector2f> openSpots;
-    
-    // Iterate through the grid to find open spots
-    for (float x = 0; x < static_cast<int>(windowWidth / getGlobalBounds().width) * getGlobalBounds().width; x += getGlobalBounds().width) {
-        for (float y = 0; y < static_cast<int>(windowHeight / getGlobalBounds().width) * getGlobalBounds().height; y += getGlobalBounds().height) {
-            FloatRect spotBounds(x, y, getGlobalBounds().width, getGlobalBounds().height);
-            
-            bool isOpen = true;
-
-            // Check against mushrooms
-            for (Mushroom& mushroom : mushrooms) {
-                if (mushroom.getHealth() > 0 && spotBounds.intersects(mushroom.getGlobalBounds())) {
-                    isOpen = false;
-                    break;
-                }
-            }
+bool ECE_Centipede::isOpenSpot(uint32_t index, const FixedRect& spotBounds, uint32_t trailingEnd) {
+    // Check against mushrooms, then against other centipede segments
+    const BoxArray& mushroomBoxes = getMushroomBoxes();
+    return mushroomBoxes.firstHit(spotBounds) == mushroomBoxes.size() && !hitsOtherSegment(index, spotBounds, trailingEnd);
+}
 
-            // Check against other centipede segments
-            if (isOpen) {
-                for (ECE_CentipedeSegment& segment : centipede.getSegments()) {
-                    if (getId() != segment.getId() && segment.getStatus() == CharacterStatus::ALIVE && spotBounds.intersects(segment.getGlobalBounds()) && !inSegmentList(getTrailingBodies(*this), segment)) {
-                        isOpen = false;
-                        break;
-                    }
-                }
-            }
-            
-            if (isOpen) {
-                openSpots.emplace_back(x, y);
+template <typename Playfield>
+FixedVec ECE_Centipede::findClosestOpenSpot(const SegmentView& segment, const Playfield& field) {
+    FixedVec currentPosition = segment.placement.position;
+    FixedVec closestSpot = currentPosition;
+    int64_t minDistance = INT64_MAX;
+    uint32_t trailingEnd = getTrailingEnd(segment.index);
+    FixedRect spotBounds = segment.bounds();
+
+    // Scan the grid keeping only the closest open spot, comparing exact squared distances in whole pixels
+    for (Fixed x = 0; x < field.gridRight; x += field.cell) {
+        for (Fixed y = 0; y < field.gridBottom; y += field.cell) {
+            int64_t distanceX = toPixels(x - currentPosition.x);
+            int64_t distanceY = toPixels(y - currentPosition.y);
+            int64_t distance = distanceX * distanceX + distanceY * distanceY;
+            spotBounds.left = x;
+            spotBounds.top = y;
+            if (distance < minDistance && isOpenSpot(segment.index, spotBounds, trailingEnd)) {
+                minDistance = distance;
+                closestSpot = {x, y};
             }
         }
     }
     
-    return openSpots;
+    return closestSpot;
 }
 
 void ECE_Centipede::reset(bool resetSpeed) {
     segments.clear();
+    segmentStates.clear();
     if (resetSpeed) {
         speed = initialSpeed;
     }
-    for (int i = 0; i < length; i++) {
-        ECE_CentipedeSegment segment(i == 0, (resetSpeed) ? initialSpeed : speed);
-        segment.setPosition((windowWidth / 2), 0);
-        segments.push_back(segment);
-    }
+    spawnSegments((resetSpeed) ? initialSpeed : speed);
 }
 
-void ECE_Centipede::draw() {
-    for (auto it = segments.rbegin(); it != segments.rend(); ++it) {
-        if (it->getStatus() == CharacterStatus::ALIVE) {
-            it->animate();
-            window.draw(*it);
+void ECE_Centipede::applyOrientations() {
+    // The orientation system: turn each living segment's renderable to the facing its AI chose
+    for (size_t i = 0; i < segmentStates.size(); i++) {
+        Entity segment = segmentStates.entityAt(i);
+        Renderable& renderable = *segments.renderables.get(segment);
+        if (isLiving(segment) && renderable.orientation != segmentStates[i].facing) {
+            renderable.orientation = segmentStates[i].facing;
+            orientationUpdates++;
         }
     }
 }
+
+void ECE_Centipede::draw() {
+    applyOrientations();
+    animateEntities(segments);
+    batch.clear();
+    batchEntities(segments, batch);
+    drawBatch(batch);
+}
+
+void reportFlowField() {
+    printf("Flow field: %llu rebuilds\n", static_cast<unsigned long long>(centipede.getFlowField().getRebuilds()));
+}
@@ -0,0 +1,99 @@
+#include "collisionEvents.h"
+#include <cstdio>
+#include "centipede.h"
+#include "laserBlaster.h"
+#include "memoryTracker.h"
+#include "mushroom.h"
+#include "spider.h"
+
+static CollisionQueue playerHits; ///< Filled by detectPlayerHits().
+static CollisionQueue blastHits; ///< Filled by detectBlastHits().
+static CollisionQueue spiderMeals; ///< Filled by detectSpiderMeals().
+static long eventsApplied = 0; ///< Events that changed the game.
+static long eventsDropped = 0; ///< Events whose blast or target an earlier event had already removed.
+
+void detectPlayerHits() {
+    MemoryScope scope(Subsystem::LASER);
+    player.detectPlayerHit(playerHits);
+}
+
+void detectBlastHits() {
+    MemoryScope scope(Subsystem::LASER);
+    player.detectBlastHits(blastHits);
+}
+
+void detectSpiderMeals() {
+    MemoryScope scope(Subsystem::SPIDER);
+    spider.detectMeals(spiderMeals);
+}
+
+/**
+ * @brief Applies one event if its blast and target are still there.
+ *
+ * @param event The event.
+ * @return true if the event was applied, false if it was stale.
+ */
+static bool applyEvent(const CollisionEvent& event) {
+    if (event.kind != CollisionKind::PLAYER_HIT && event.kind != CollisionKind::SPIDER_MEAL && !player.hasBlast(event.blast)) {
+        return false;
+    }
+
+    switch (event.kind) {
+        case CollisionKind::PLAYER_HIT:
+            player.loseLife();
+            return true;
+        case CollisionKind::BLAST_MUSHROOM:
+            if (!mushrooms.alive(event.target) || mushrooms.healths.get(event.target)->hitPoints <= 0) {
+                return false;
+            }
+            hitMushroom(event.target);
+            break;
+        case CollisionKind::BLAST_SEGMENT: {
+            if (!centipede.isLiving(event.target)) {
+                return false;
+            }
+
+            // Score 100 for a head and 10 for a body, then kill the segment and leave a mushroom in its place
+            player.incrementScore((centipede.getSegmentStates().get(event.target)->type == SegmentType::HEAD) ? 100 : 10);
+            centipede.killSegment(event.target);
+            FixedVec position = centipede.getSegments().placements.get(event.target)->position;
+            addMushroom(toPixels(position.x), toPixels(position.y));
+            break;
+        }
+        case CollisionKind::BLAST_SPIDER:
+            if (spider.getStatus() != CharacterStatus::ALIVE) {
+                return false;
+            }
+            spider.handleCollision();
+            player.incrementScore(500);
+            break;
+        case CollisionKind::SPIDER_MEAL:
+            if (!mushrooms.alive(event.target) || mushrooms.healths.get(event.target)->hitPoints <= 0) {
+                return false;
+            }
+            eatMushroom(event.target);
+            return true;
+    }
+
+    // Every blast is spent on the first thing it hits
+    player.removeBlast(event.blast);
+    return true;
+}
+
+void resolveCollisions() {
+    MemoryScope scope(Subsystem::LASER);
+    for (CollisionQueue* queue : {&playerHits, &blastHits, &spiderMeals}) {
+        for (const CollisionEvent& event : queue->getEvents()) {
+            if (applyEvent(event)) {
+                eventsApplied++;
+            } else {
+                eventsDropped++;
+            }
+        }
+        queue->clear();
+    }
+}
+
+void reportCollisionEvents() {
+    printf("Collision events: %ld applied, %ld dropped as stale\n", eventsApplied, eventsDropped);
+}
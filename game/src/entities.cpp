@@ -0,0 +1,62 @@
+#include "entities.h"
+#include "animation.h"
+
+Entity EntityStore::create() {
+    uint32_t index;
+    if (freeIndices.empty()) {
+        index = static_cast<uint32_t>(generations.size());
+        generations.push_back(0);
+        live.push_back(0);
+    } else {
+        index = freeIndices.back();
+        freeIndices.pop_back();
+    }
+    live[index] = 1;
+    count++;
+    return Entity{index, generations[index]};
+}
+
+bool EntityStore::destroy(Entity entity) {
+    if (!alive(entity)) {
+        return false;
+    }
+    placements.remove(entity);
+    colliders.remove(entity);
+    healths.remove(entity);
+    renderables.remove(entity);
+    animations.remove(entity);
+    motions.remove(entity);
+    live[entity.index] = 0;
+    generations[entity.index]++;
+    freeIndices.push_back(entity.index);
+    count--;
+    return true;
+}
+
+void EntityStore::clear() {
+    placements.clear();
+    colliders.clear();
+    healths.clear();
+    renderables.clear();
+    animations.clear();
+    motions.clear();
+    freeIndices.clear();
+    for (uint32_t i = static_cast<uint32_t>(generations.size()); i-- > 0;) {
+        if (live[i]) {
+            live[i] = 0;
+            generations[i]++;
+        }
+        freeIndices.push_back(i);
+    }
+    count = 0;
+}
+
+void animateEntities(EntityStore& store) {
+    for (size_t i = 0; i < store.animations.size(); ++i) {
+        const Animation& animation = store.animations[i];
+        Renderable* renderable = store.renderables.get(store.animations.entityAt(i));
+        if (renderable && !animation.frames->empty()) {
+            renderable->texture = &(*animation.frames)[getAnimationFrame(animation.phase, animation.ticksPerFrame, animation.frames->size())];
+        }
+    }
+}
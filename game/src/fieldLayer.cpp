@@ -0,0 +1,128 @@
+#include "fieldLayer.h"
+#include <cstdio>
+#include <vector>
+#include "mushroom.h"
+#include "memoryTracker.h"
+#include "renderBackend.h"
+#include "spriteBatch.h"
+
+static RenderTexture fieldLayer; ///< The cached background and mushroom layer.
+static Framebuffer softwareLayer; ///< The cached layer when rendering in software.
+static Sprite fieldSprite; ///< The sprite drawing the cached layer to the window.
+static const Sprite* backgroundSprite = nullptr; ///< The background composited under the mushrooms.
+static bool fieldLayerStale = true; ///< Whether the whole layer must be recomposited.
+static std::vector<FloatRect> pendingPatches; ///< Areas to repaint on the next draw.
+static SpriteBatch mushroomBatch; ///< The mushroom quads being composited into the layer.
+static FieldLayerStats fieldLayerStats = {0, 0, 0}; ///< Counters of how each frame's layer was produced.
+
+static const size_t maxPatches = 32; ///< Beyond this many patches a full rebuild is cheaper.
+
+void fieldLayerInit(const Sprite& background) {
+    MemoryScope scope(Subsystem::TEXTURES);
+    backgroundSprite = &background;
+    if (isSoftwareRendering()) {
+        softwareLayer.create(windowWidth, windowHeight);
+    } else {
+        fieldLayer.create(windowWidth, windowHeight);
+        fieldSprite.setTexture(fieldLayer.getTexture(), true);
+    }
+    pendingPatches.reserve(maxPatches);
+    invalidateFieldLayer();
+}
+
+void invalidateFieldLayer() {
+    fieldLayerStale = true;
+    pendingPatches.clear();
+}
+
+void patchFieldLayer(const FloatRect& area) {
+    if (fieldLayerStale) {
+        return;
+    }
+    if (pendingPatches.size() >= maxPatches) {
+        invalidateFieldLayer();
+        return;
+    }
+    pendingPatches.push_back(area);
+}
+
+/**
+ * @brief Repaints one area of the cached layer, clipped to that area.
+ *
+ * @param area The area of the playfield to repaint.
+ */
+static void repaint(const FloatRect& area) {
+    mushroomBatch.clear();
+    batchEntities(mushrooms, mushroomBatch, &area);
+    if (isSoftwareRendering()) {
+        softwareLayer.setClip(area);
+        softwareLayer.draw(*backgroundSprite);
+        mushroomBatch.draw(softwareLayer);
+        softwareLayer.resetClip();
+        return;
+    }
+
+    // Restrict drawing to the area by mapping a view of it onto the same viewport
+    View clip(area);
+    clip.setViewport(FloatRect(area.left / windowWidth, area.top / windowHeight, area.width / windowWidth, area.height / windowHeight));
+    fieldLayer.setView(clip);
+    fieldLayer.draw(*backgroundSprite);
+    mushroomBatch.draw(fieldLayer);
+    fieldLayer.setView(fieldLayer.getDefaultView());
+}
+
+/**
+ * @brief Recomposites the whole cached layer.
+ */
+static void rebuild() {
+    mushroomBatch.clear();
+    batchEntities(mushrooms, mushroomBatch);
+    if (isSoftwareRendering()) {
+        softwareLayer.clear();
+        softwareLayer.draw(*backgroundSprite);
+        mushroomBatch.draw(softwareLayer);
+        return;
+    }
+
+    fieldLayer.clear();
+    fieldLayer.draw(*backgroundSprite);
+    mushroomBatch.draw(fieldLayer);
+    fieldLayer.display();
+}
+
+void drawFieldLayer() {
+    MemoryScope scope(Subsystem::TEXTURES);
+
+    if (fieldLayerStale) {
+        // Recomposite the whole layer
+        rebuild();
+        fieldLayerStale = false;
+        fieldLayerStats.rebuilds++;
+    } else if (!pendingPatches.empty()) {
+        // Repaint only the cells that changed
+        for (const FloatRect& area : pendingPatches) {
+            repaint(area);
+        }
+        if (!isSoftwareRendering()) {
+            fieldLayer.display();
+        }
+        pendingPatches.clear();
+        fieldLayerStats.patches++;
+    } else {
+        fieldLayerStats.hits++;
+    }
+
+    if (isSoftwareRendering()) {
+        framebuffer.draw(softwareLayer);
+    } else {
+        window.draw(fieldSprite);
+    }
+}
+
+const FieldLayerStats& getFieldLayerStats() {
+    return fieldLayerStats;
+}
+
+void reportFieldLayerStats() {
+    printf("Field layer cache: %ld hits, %ld patches, %ld rebuilds\n", fieldLayerStats.hits, fieldLayerStats.patches, fieldLayerStats.rebuilds);
+}
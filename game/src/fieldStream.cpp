@@ -0,0 +1,139 @@
+#include "fieldStream.h"
+#include <algorithm>
+#include <cmath>
+#include <cstdlib>
+#include <cstring>
+#include <random>
+#include <vector>
+#include "centipede.h"
+#include "frameArena.h"
+#include "globals.h"
+#include "laserBlaster.h"
+#include "memoryTracker.h"
+#include "mushroom.h"
+#include "renderBackend.h"
+
+static const int chunkRows = 8; ///< The number of rows generated at once.
+
+static bool endless = false; ///< Whether --endless was given.
+static int ticksPerRow = 30; ///< The number of ticks the field takes to scroll one row.
+static int rowTicks = 0; ///< The ticks since the last row scrolled.
+static uint32_t streamSeed = 0; ///< The seed of the current field.
+static uint64_t scrolledRows = 0; ///< The rows scrolled since the field was reset.
+static uint64_t nextChunk = 0; ///< The index of the next chunk to generate.
+static std::vector<uint8_t> chunk; ///< The health of every cell of the buffered chunk, row by row in the order they enter.
+static int chunkRow = chunkRows; ///< The next row of the buffered chunk to enter, chunkRows once it is used up.
+
+/**
+ * @brief Returns the number of mushroom columns, inside a 1 sprite left and right border.
+ */
+static int getColumns() {
+    return std::max(0, windowWidth / static_cast<int>(getTextureSize(normalMushroomTexture).x) - 2);
+}
+
+/**
+ * @brief Generates the next chunk into the buffer.
+ *
+ * Chunks are as dense as a generated fixed field.
+ */
+static void generateChunk() {
+    int columns = getColumns();
+    int fieldRows = std::max(1, windowHeight / static_cast<int>(getTextureSize(normalMushroomTexture).y) - 4);
+    uint32_t cells = static_cast<uint32_t>(columns * chunkRows);
+    uint32_t count = std::min(cells, static_cast<uint32_t>(std::lround(static_cast<double>(mushroomsPerField) * chunkRows / fieldRows)));
+
+    // Every chunk has its own generator, so a chunk does not depend on the ones before it
+    std::seed_seq sequence{streamSeed, static_cast<uint32_t>(nextChunk), static_cast<uint32_t>(nextChunk >> 32)};
+    std::mt19937 gen(sequence);
+    std::pmr::vector<uint32_t> picked(frameArena());
+    sampleDistinctCells(cells, count, gen, picked);
+
+    chunk.assign(cells, 0);
+    for (uint32_t cell : picked) {
+        chunk[cell] = 2;
+    }
+    chunkRow = 0;
+    nextChunk++;
+}
+
+/**
+ * @brief Moves the field down one row and lets the next row enter at the top.
+ */
+static void scrollRow() {
+    int width = getTextureSize(normalMushroomTexture).x;
+    int height = getTextureSize(normalMushroomTexture).y;
+    scrollMushrooms(toFixed(height), toFixed((windowHeight / height - 3) * height));
+
+    // Enter the next buffered row, generating the next chunk once the buffer runs out
+    if (chunkRow == chunkRows) {
+        generateChunk();
+    }
+    int columns = getColumns();
+    for (int column = 0; column < columns; ++column) {
+        uint8_t health = chunk[chunkRow * columns + column];
+        if (health != 0) {
+            addMushroom((column + 1) * width, 0, health);
+        }
+    }
+    chunkRow++;
+    scrolledRows++;
+
+    // Crush the mushrooms that landed on the player or the centipede
+    FixedRect playerBounds = player.getFixedBounds();
+    const BoxArray& segmentBoxes = centipede.getSegmentBoxes();
+    for (size_t i = 0; i < mushrooms.placements.size();) {
+        Entity mushroom = mushrooms.placements.entityAt(i);
+        FixedRect bounds = getMushroomBounds(mushroom);
+        if (bounds.intersects(playerBounds) || segmentBoxes.firstHit(bounds) < segmentBoxes.size()) {
+            // Removing moves the last mushroom into this index, which is visited next
+            removeMushroom(mushroom);
+        } else {
+            ++i;
+        }
+    }
+}
+
+void parseFieldStreamArgs(int argc, char* argv[]) {
+    for (int i = 1; i < argc; ++i) {
+        if (strcmp(argv[i], "--endless") == 0) {
+            endless = true;
+            if (i + 1 < argc && argv[i + 1][0] != '-') {
+                ticksPerRow = std::max(1, atoi(argv[++i]));
+            }
+        }
+    }
+}
+
+bool isEndless() {
+    return endless;
+}
+
+void resetFieldStream(uint32_t seed) {
+    MemoryScope scope(Subsystem::MUSHROOM);
+    clearMushrooms();
+    streamSeed = seed;
+    scrolledRows = 0;
+    nextChunk = 0;
+    chunkRow = chunkRows;
+    rowTicks = 0;
+
+    // Scroll in every row down to the bottom border
+    int rows = windowHeight / static_cast<int>(getTextureSize(normalMushroomTexture).y) - 3;
+    for (int row = 0; row < rows; ++row) {
+        scrollRow();
+    }
+    scrolledRows = 0;
+}
+
+void scrollFieldStream() {
+    if (!endless || ++rowTicks < ticksPerRow) {
+        return;
+    }
+    MemoryScope scope(Subsystem::MUSHROOM);
+    rowTicks = 0;
+    scrollRow();
+}
+
+uint64_t getScrolledRows() {
+    return scrolledRows;
+}
@@ -0,0 +1,101 @@
+#include "flowField.h"
+#include <algorithm>
+
+void FlowField::update(int columns, int rows, Fixed cell, int targetRow, const BoxArray& mushroomBoxes, uint32_t version) {
+    // A window smaller than one cell has no grid to steer over
+    if (columns <= 0 || rows <= 0 || cell <= 0) {
+        computed = false;
+        return;
+    }
+    targetRow = std::clamp(targetRow, 0, rows - 1);
+    if (computed && columns == this->columns && rows == this->rows && cell == this->cell && targetRow == this->targetRow
+        && version == this->version) {
+        return;
+    }
+    this->columns = columns;
+    this->rows = rows;
+    this->cell = cell;
+    this->targetRow = targetRow;
+    this->version = version;
+    computed = true;
+    rebuilds++;
+
+    size_t cellCount = size_t(columns) * rows;
+    blocked.assign(cellCount, 0);
+    distances.assign(cellCount, unreachable);
+    steps.assign(cellCount * 2, 0);
+    frontier.clear();
+    frontier.reserve(cellCount);
+
+    // Mark every cell a mushroom overlaps, edges touching the next cell do not count
+    for (size_t i = 0; i < mushroomBoxes.size(); i++) {
+        FixedRect box = mushroomBoxes.getBox(i);
+        int left = std::max(0, box.left / cell);
+        int top = std::max(0, box.top / cell);
+        int right = std::min(columns - 1, (box.left + box.width - 1) / cell);
+        int bottom = std::min(rows - 1, (box.top + box.height - 1) / cell);
+        for (int row = top; row <= bottom; row++) {
+            for (int column = left; column <= right; column++) {
+                blocked[size_t(row) * columns + column] = 1;
+            }
+        }
+    }
+
+    // Search outwards from the open cells of the target row
+    for (int column = 0; column < columns; column++) {
+        uint32_t index = uint32_t(targetRow) * columns + column;
+        if (!blocked[index]) {
+            distances[index] = 0;
+            frontier.push_back(index);
+        }
+    }
+    for (size_t next = 0; next < frontier.size(); next++) {
+        uint32_t index = frontier[next];
+        int column = index % columns;
+        int row = index / columns;
+        uint32_t distance = distances[index] + 1;
+        auto visit = [&](int neighbourColumn, int neighbourRow) {
+            if (neighbourColumn < 0 || neighbourColumn >= columns || neighbourRow < 0 || neighbourRow >= rows) {
+                return;
+            }
+            uint32_t neighbour = uint32_t(neighbourRow) * columns + neighbourColumn;
+            if (!blocked[neighbour] && distances[neighbour] == unreachable) {
+                distances[neighbour] = distance;
+                frontier.push_back(neighbour);
+            }
+        };
+        visit(column - 1, row);
+        visit(column + 1, row);
+        visit(column, row - 1);
+        visit(column, row + 1);
+    }
+
+    // A head steps into the row above or below, landing straight there or one column on
+    for (int row = 0; row < rows; row++) {
+        for (int column = 0; column < columns; column++) {
+            size_t index = size_t(row) * columns + column;
+            for (int side = 0; side < 2; side++) {
+                int dx = side ? 1 : -1;
+                uint32_t up = std::min(distanceAt(column, row - 1), distanceAt(column + dx, row - 1));
+                uint32_t down = std::min(distanceAt(column, row + 1), distanceAt(column + dx, row + 1));
+                steps[index * 2 + side] = (up < down) ? -1 : (down < up) ? 1 : 0;
+            }
+        }
+    }
+}
+
+int FlowField::verticalStep(const FixedVec& position, int dx) const {
+    if (!computed || dx == 0) {
+        return 0;
+    }
+    int column = std::clamp((position.x + cell / 2) / cell, 0, columns - 1);
+    int row = std::clamp((position.y + cell / 2) / cell, 0, rows - 1);
+    return steps[(size_t(row) * columns + column) * 2 + (dx > 0)];
+}
+
+uint32_t FlowField::distanceAt(int column, int row) const {
+    if (column < 0 || column >= columns || row < 0 || row >= rows) {
+        return unreachable;
+    }
+    return distances[size_t(row) * columns + column];
+}
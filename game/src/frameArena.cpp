@@ -0,0 +1,60 @@
+#include "frameArena.h"
+#include <cassert>
+#include <cstddef>
+#include <cstdio>
+#include "memoryTracker.h"
+
+/**
+ * @class ArenaUpstream
+ * @brief Upstream of the frame arena that counts how often the fixed buffer overflows.
+ */
+class ArenaUpstream : public std::pmr::memory_resource {
+    public:
+        long overflows = 0; ///< The number of allocations that did not fit the fixed buffer.
+
+    private:
+        void* do_allocate(std::size_t bytes, std::size_t alignment) override {
+            overflows++;
+            return std::pmr::new_delete_resource()->allocate(bytes, alignment);
+        }
+        void do_deallocate(void* ptr, std::size_t bytes, std::size_t alignment) override {
+            std::pmr::new_delete_resource()->deallocate(ptr, bytes, alignment);
+        }
+        bool do_is_equal(const std::pmr::memory_resource& other) const noexcept override {
+            return this == &other;
+        }
+};
+
+static const std::size_t arenaSize = 256 * 1024; ///< The size of the fixed arena buffer.
+alignas(std::max_align_t) static std::byte arenaBuffer[arenaSize]; ///< The fixed arena buffer.
+static ArenaUpstream arenaUpstream; ///< Fallback for frames that outgrow the buffer.
+static std::pmr::monotonic_buffer_resource arena(arenaBuffer, arenaSize, &arenaUpstream); ///< The frame arena.
+
+static long steadyFrames = 0; ///< The number of steady-state frames checked.
+static long allocatingSteadyFrames = 0; ///< The number of steady-state frames that touched the heap.
+
+std::pmr::memory_resource* frameArena() {
+    return &arena;
+}
+
+void frameArenaReset() {
+    arena.release();
+}
+
+void checkFrameAllocations(long allocationsBefore, bool steadyState) {
+    if (!steadyState) {
+        return;
+    }
+    long allocations = getHeapAllocationCount() - allocationsBefore;
+    steadyFrames++;
+    if (allocations > 0) {
+        allocatingSteadyFrames++;
+    }
+#ifdef CENTIPEDE_ASSERT_NO_FRAME_ALLOCS
+    assert(allocations == 0 && "steady-state frame allocated from the general heap");
+#endif
+}
+
+void reportFrameAllocations() {
+    printf("Frame allocations: %ld of %ld steady-state frames touched the heap, %ld arena overflows\n", allocatingSteadyFrames, steadyFrames, arenaUpstream.overflows);
+}
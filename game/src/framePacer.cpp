@@ -0,0 +1,75 @@
+#include "framePacer.h"
+#include <algorithm>
+#include <cstdio>
+#include <thread>
+
+static const size_t histogramBuckets = 10000; ///< 10 microsecond buckets covering 100 ms, the last one is unbounded.
+
+FramePacer::FramePacer(double targetFrameTime, double spinTime) {
+    this->targetFrameTime = std::chrono::duration_cast<SteadyClock::duration>(std::chrono::duration<double>(targetFrameTime));
+    this->spinTime = std::chrono::duration_cast<SteadyClock::duration>(std::chrono::duration<double>(spinTime));
+    frameTimes.assign(histogramBuckets, 0);
+    jitters.assign(histogramBuckets, 0);
+    maxFrameTime = 0;
+    maxJitter = 0;
+    frameCount = 0;
+    lastFrame = SteadyClock::now();
+    deadline = lastFrame + this->targetFrameTime;
+}
+
+void FramePacer::record(std::vector<uint32_t>& histogram, long micros) {
+    size_t bucket = std::min(static_cast<size_t>(std::max(micros, 0L) / 10), histogram.size() - 1);
+    histogram[bucket]++;
+}
+
+double FramePacer::percentile(const std::vector<uint32_t>& histogram, double percentile) {
+    long total = 0;
+    for (uint32_t count : histogram) {
+        total += count;
+    }
+    long target = static_cast<long>(percentile * total);
+    long seen = 0;
+    for (size_t i = 0; i < histogram.size(); ++i) {
+        seen += histogram[i];
+        if (seen > target) {
+            return (i + 1) * 0.01;
+        }
+    }
+    return histogram.size() * 0.01;
+}
+
+void FramePacer::wait() {
+    // Sleep coarsely, leaving the last stretch before the deadline to the spin
+    SteadyClock::time_point now = SteadyClock::now();
+    if (deadline - now > spinTime) {
+        std::this_thread::sleep_until(deadline - spinTime);
+    }
+    // Spin out the remainder for an exact wake up
+    while ((now = SteadyClock::now()) < deadline) {
+    }
+
+    // Record how late the wake up was and how long the whole frame took
+    long jitter = std::chrono::duration_cast<std::chrono::microseconds>(now - deadline).count();
+    long frameTime = std::chrono::duration_cast<std::chrono::microseconds>(now - lastFrame).count();
+    record(jitters, jitter);
+    record(frameTimes, frameTime);
+    maxJitter = std::max(maxJitter, jitter);
+    maxFrameTime = std::max(maxFrameTime, frameTime);
+    frameCount++;
+    lastFrame = now;
+
+    // Advance the deadline by exactly one frame, resyncing if the frame overran by more than that
+    deadline += targetFrameTime;
+    if (deadline < now) {
+        deadline = now + targetFrameTime;
+    }
+}
+
+void FramePacer::report() const {
+    if (frameCount == 0) {
+        return;
+    }
+    printf("Frame pacing (%ld frames):\n", frameCount);
+    printf("  Frame time p50 %.2f ms, p99 %.2f ms, max %.2f ms\n", percentile(frameTimes, 0.5), percentile(frameTimes, 0.99), maxFrameTime / 1000.0);
+    printf("  Jitter     p50 %.2f ms, p99 %.2f ms, max %.2f ms\n", percentile(jitters, 0.5), percentile(jitters, 0.99), maxJitter / 1000.0);
+}
@@ -0,0 +1,527 @@
+#include "framebuffer.h"
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include <cstring>
+#include <map>
+#include <unordered_map>
+#include "fixedPoint.h"
+
+#if defined(CENTIPEDE_FREETYPE)
+#include <ft2build.h>
+#include FT_FREETYPE_H
+#endif
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#include <emmintrin.h>
+#define FRAMEBUFFER_SSE2
+#endif
+
+static std::unordered_map<const Texture*, Image> textureImages; ///< The pixels of every texture given to setTextureImage().
+static bool simdSpans = true; ///< Whether spans are blended with SSE2 where available.
+
+static const uint32_t opaqueAlpha = 0xFF000000u; ///< The alpha byte of an RGBA pixel read as a little-endian word.
+
+/**
+ * @brief Returns the pixels of a texture, or an empty image if none were set.
+ *
+ * @param texture The texture.
+ * @return const Image& The pixels.
+ */
+static const Image& textureImage(const Texture& texture) {
+    static const Image empty;
+    auto found = textureImages.find(&texture);
+    return (found != textureImages.end()) ? found->second : empty;
+}
+
+/**
+ * @struct SoftwareGlyph
+ * @brief Where a glyph is in its atlas and how it is placed along the baseline.
+ */
+struct SoftwareGlyph {
+    float advance = 0; ///< The distance to the next glyph's origin.
+    FloatRect bounds; ///< The glyph's box relative to its origin on the baseline.
+    IntRect textureRect; ///< The glyph's texels in the atlas.
+};
+
+#if defined(CENTIPEDE_FREETYPE)
+static const Uint32 firstGlyph = ' '; ///< The first character an atlas holds.
+static const size_t glyphCount = '~' - ' ' + 1; ///< The printable ASCII characters an atlas holds.
+
+/**
+ * @struct GlyphAtlas
+ * @brief The printable ASCII glyphs of a font at one size, rasterized by FreeType.
+ */
+struct GlyphAtlas {
+    Image image; ///< Every glyph side by side, white with the coverage as alpha.
+    SoftwareGlyph glyphs[glyphCount]; ///< The glyphs, by character.
+    std::vector<float> kerning; ///< The kerning of every pair of characters, row by previous character.
+};
+
+static FT_Library freetype = nullptr; ///< The FreeType instance, created by the first loadGlyphFont().
+static std::unordered_map<const Font*, FT_Face> glyphFaces; ///< The face of every font given to loadGlyphFont().
+static std::map<std::pair<const Font*, unsigned>, GlyphAtlas> glyphAtlases; ///< The atlases built by prepareGlyphs().
+
+/**
+ * @brief Returns the atlas of a font at a size, or null if prepareGlyphs() did not build it.
+ */
+static const GlyphAtlas* findAtlas(const Font& font, unsigned characterSize) {
+    auto found = glyphAtlases.find({&font, characterSize});
+    return (found != glyphAtlases.end()) ? &found->second : nullptr;
+}
+#endif
+
+/**
+ * @brief Lays out a single line of text the way sf::Text does, a character size below the top.
+ *
+ * Glyphs come from the FreeType atlas when prepareGlyphs() built one, and from
+ * the font's own glyph pages otherwise.
+ *
+ * @param text The text.
+ * @param visit Called with the image, the glyph and its origin for every character.
+ */
+template <typename Visitor>
+static void layoutText(const Text& text, Visitor&& visit) {
+    const Font* font = text.getFont();
+    if (!font) {
+        return;
+    }
+    unsigned characterSize = text.getCharacterSize();
+    const String& string = text.getString();
+    float x = 0;
+    float y = static_cast<float>(characterSize);
+    Uint32 previous = 0;
+
+#if defined(CENTIPEDE_FREETYPE)
+    if (const GlyphAtlas* atlas = findAtlas(*font, characterSize)) {
+        for (size_t i = 0; i < string.getSize(); ++i) {
+            Uint32 character = string[i];
+            if (character < firstGlyph || character >= firstGlyph + glyphCount) {
+                continue;
+            }
+            size_t index = character - firstGlyph;
+            if (previous) {
+                x += atlas->kerning[(previous - firstGlyph) * glyphCount + index];
+            }
+            previous = character;
+            visit(atlas->image, atlas->glyphs[index], character, x, y);
+            x += atlas->glyphs[index].advance;
+        }
+        return;
+    }
+#endif
+
+    const Image& glyphs = textureImage(font->getTexture(characterSize));
+    for (size_t i = 0; i < string.getSize(); ++i) {
+        Uint32 character = string[i];
+        x += font->getKerning(previous, character, characterSize);
+        previous = character;
+
+        const Glyph& glyph = font->getGlyph(character, characterSize, false);
+        SoftwareGlyph placed;
+        placed.advance = glyph.advance;
+        placed.bounds = glyph.bounds;
+        placed.textureRect = glyph.textureRect;
+        visit(glyphs, placed, character, x, y);
+        x += glyph.advance;
+    }
+}
+
+/**
+ * @brief Divides a product of two 8-bit values by 255, exactly for every such product.
+ *
+ * @param value The product.
+ * @return uint32_t The quotient, rounded down.
+ */
+static inline uint32_t divide255(uint32_t value) {
+    return (value + 1 + (value >> 8)) >> 8;
+}
+
+/**
+ * @brief Blends one texel over one frame pixel, leaving the pixel opaque.
+ *
+ * @param dst The frame pixel.
+ * @param src The texel, with straight alpha.
+ * @return uint32_t The blended pixel.
+ */
+static inline uint32_t blendPixel(uint32_t dst, uint32_t src) {
+    uint32_t alpha = src >> 24;
+    uint32_t inverse = 255 - alpha;
+    uint32_t result = opaqueAlpha;
+    for (int shift = 0; shift < 24; shift += 8) {
+        uint32_t channel = divide255(((src >> shift) & 0xFF) * alpha + ((dst >> shift) & 0xFF) * inverse);
+        result |= channel << shift;
+    }
+    return result;
+}
+
+/**
+ * @brief Blends a span of texels over a run of frame pixels.
+ *
+ * Groups of 4 fully transparent texels are skipped and groups of 4 opaque
+ * ones stored directly, which covers most of every sprite.
+ *
+ * @param dst The first frame pixel.
+ * @param src The texels.
+ * @param count The number of pixels.
+ */
+static void blendSpan(uint32_t* dst, const uint32_t* src, size_t count) {
+    size_t i = 0;
+#if defined(FRAMEBUFFER_SSE2)
+    if (simdSpans) {
+        const __m128i zero = _mm_setzero_si128();
+        const __m128i full = _mm_set1_epi16(255);
+        const __m128i one = _mm_set1_epi16(1);
+        const __m128i alphaMask = _mm_set1_epi32(static_cast<int>(opaqueAlpha));
+        for (; i + 4 <= count; i += 4) {
+            __m128i s = _mm_loadu_si128(reinterpret_cast<const __m128i*>(src + i));
+            __m128i alpha = _mm_and_si128(s, alphaMask);
+            if (_mm_movemask_epi8(_mm_cmpeq_epi32(alpha, zero)) == 0xFFFF) {
+                continue;
+            }
+            if (_mm_movemask_epi8(_mm_cmpeq_epi32(alpha, alphaMask)) == 0xFFFF) {
+                _mm_storeu_si128(reinterpret_cast<__m128i*>(dst + i), s);
+                continue;
+            }
+
+            // Widen to 16 bits per channel, 2 pixels per register, and spread each alpha over its pixel
+            __m128i d = _mm_loadu_si128(reinterpret_cast<const __m128i*>(dst + i));
+            __m128i sLow = _mm_unpacklo_epi8(s, zero);
+            __m128i sHigh = _mm_unpackhi_epi8(s, zero);
+            __m128i aLow = _mm_shufflehi_epi16(_mm_shufflelo_epi16(sLow, _MM_SHUFFLE(3, 3, 3, 3)), _MM_SHUFFLE(3, 3, 3, 3));
+            __m128i aHigh = _mm_shufflehi_epi16(_mm_shufflelo_epi16(sHigh, _MM_SHUFFLE(3, 3, 3, 3)), _MM_SHUFFLE(3, 3, 3, 3));
+
+            // src * alpha + dst * (255 - alpha) stays within 16 bits
+            __m128i low = _mm_add_epi16(_mm_mullo_epi16(sLow, aLow), _mm_mullo_epi16(_mm_unpacklo_epi8(d, zero), _mm_sub_epi16(full, aLow)));
+            __m128i high = _mm_add_epi16(_mm_mullo_epi16(sHigh, aHigh), _mm_mullo_epi16(_mm_unpackhi_epi8(d, zero), _mm_sub_epi16(full, aHigh)));
+            low = _mm_srli_epi16(_mm_add_epi16(_mm_add_epi16(low, one), _mm_srli_epi16(low, 8)), 8);
+            high = _mm_srli_epi16(_mm_add_epi16(_mm_add_epi16(high, one), _mm_srli_epi16(high, 8)), 8);
+            __m128i result = _mm_or_si128(_mm_packus_epi16(low, high), alphaMask);
+            _mm_storeu_si128(reinterpret_cast<__m128i*>(dst + i), result);
+        }
+    }
+#endif
+    for (; i < count; ++i) {
+        uint32_t alpha = src[i] >> 24;
+        if (alpha == 255) {
+            dst[i] = src[i];
+        } else if (alpha != 0) {
+            dst[i] = blendPixel(dst[i], src[i]);
+        }
+    }
+}
+
+/**
+ * @brief Converts a per-pixel texture step to fixed point without the rounding of a float.
+ *
+ * @param value The step in texels.
+ * @return Fixed The step in fixed point.
+ */
+static Fixed toFixedStep(double value) {
+    return static_cast<Fixed>(std::llround(value * FIXED_ONE));
+}
+
+void Framebuffer::create(unsigned width, unsigned height) {
+    this->width = width;
+    this->height = height;
+    pixels.assign(static_cast<size_t>(width) * height, opaqueAlpha);
+    span.resize(width);
+    resetClip();
+}
+
+void Framebuffer::clear(const Color& color) {
+    uint32_t pixel = static_cast<uint32_t>(color.r) | (static_cast<uint32_t>(color.g) << 8) | (static_cast<uint32_t>(color.b) << 16) | opaqueAlpha;
+    std::fill(pixels.begin(), pixels.end(), pixel);
+}
+
+void Framebuffer::setClip(const FloatRect& area) {
+    int left = std::max(0, static_cast<int>(std::floor(area.left)));
+    int top = std::max(0, static_cast<int>(std::floor(area.top)));
+    int right = std::min(static_cast<int>(width), static_cast<int>(std::ceil(area.left + area.width)));
+    int bottom = std::min(static_cast<int>(height), static_cast<int>(std::ceil(area.top + area.height)));
+    clip = IntRect(left, top, std::max(0, right - left), std::max(0, bottom - top));
+}
+
+void Framebuffer::resetClip() {
+    clip = IntRect(0, 0, static_cast<int>(width), static_cast<int>(height));
+}
+
+void Framebuffer::draw(const Sprite& sprite) {
+    if (sprite.getTexture()) {
+        drawQuad(textureImage(*sprite.getTexture()), sprite.getTextureRect(), sprite.getTransform(), sprite.getColor());
+    }
+}
+
+void Framebuffer::draw(const Texture& texture, const Transform& transform) {
+    const Image& image = textureImage(texture);
+    Vector2u size = image.getSize();
+    drawQuad(image, IntRect(0, 0, static_cast<int>(size.x), static_cast<int>(size.y)), transform, Color::White);
+}
+
+void Framebuffer::draw(const Text& text) {
+    layoutText(text, [&](const Image& glyphs, const SoftwareGlyph& glyph, Uint32, float x, float y) {
+        if (glyph.textureRect.width > 0 && glyph.textureRect.height > 0) {
+            Transform quad = text.getTransform();
+            quad.translate(x + glyph.bounds.left, y + glyph.bounds.top);
+            drawQuad(glyphs, glyph.textureRect, quad, text.getFillColor());
+        }
+    });
+}
+
+void Framebuffer::draw(const Framebuffer& layer) {
+    if (layer.width != width || layer.height != height) {
+        return;
+    }
+    for (int y = clip.top; y < clip.top + clip.height; ++y) {
+        size_t offset = static_cast<size_t>(y) * width + clip.left;
+        memcpy(&pixels[offset], &layer.pixels[offset], clip.width * sizeof(uint32_t));
+    }
+}
+
+void Framebuffer::drawQuad(const Image& image, const IntRect& textureRect, const Transform& transform, const Color& color) {
+    const uint32_t* texels = reinterpret_cast<const uint32_t*>(image.getPixelsPtr());
+    int imageWidth = static_cast<int>(image.getSize().x);
+    int imageHeight = static_cast<int>(image.getSize().y);
+    int quadWidth = std::abs(textureRect.width);
+    int quadHeight = std::abs(textureRect.height);
+    if (!texels || quadWidth == 0 || quadHeight == 0) {
+        return;
+    }
+
+    // Only the rows and columns under both the quad and the clip area are visited
+    FloatRect bounds = transform.transformRect(FloatRect(0, 0, static_cast<float>(quadWidth), static_cast<float>(quadHeight)));
+    int left = std::max(clip.left, static_cast<int>(std::floor(bounds.left)));
+    int top = std::max(clip.top, static_cast<int>(std::floor(bounds.top)));
+    int right = std::min(clip.left + clip.width, static_cast<int>(std::ceil(bounds.left + bounds.width)));
+    int bottom = std::min(clip.top + clip.height, static_cast<int>(std::ceil(bounds.top + bounds.height)));
+    if (left >= right || top >= bottom) {
+        return;
+    }
+
+    // Invert the transform so each frame pixel center maps back to a quad position
+    const float* matrix = transform.getMatrix();
+    double a = matrix[0], b = matrix[4], tx = matrix[12];
+    double c = matrix[1], d = matrix[5], ty = matrix[13];
+    double determinant = a * d - b * c;
+    if (determinant == 0) {
+        return;
+    }
+    Fixed stepU = toFixedStep(d / determinant);
+    Fixed stepV = toFixedStep(-c / determinant);
+
+    // Mirrored texture rects read their texels backwards from the rect's edge
+    int texelLeft = (textureRect.width >= 0) ? textureRect.left : textureRect.left - 1;
+    int texelTop = (textureRect.height >= 0) ? textureRect.top : textureRect.top - 1;
+    int texelStepX = (textureRect.width >= 0) ? 1 : -1;
+    int texelStepY = (textureRect.height >= 0) ? 1 : -1;
+    bool tinted = color.r != 255 || color.g != 255 || color.b != 255 || color.a != 255;
+    size_t count = static_cast<size_t>(right - left);
+
+    for (int y = top; y < bottom; ++y) {
+        double px = left + 0.5 - tx;
+        double py = y + 0.5 - ty;
+        Fixed u = toFixedStep((d * px - b * py) / determinant);
+        Fixed v = toFixedStep((a * py - c * px) / determinant);
+
+        // Fetch the row's texels into the span, transparent wherever the row leaves the quad
+        for (size_t i = 0; i < count; ++i, u += stepU, v += stepV) {
+            int quadX = u >> FIXED_SHIFT;
+            int quadY = v >> FIXED_SHIFT;
+            uint32_t texel = 0;
+            if (static_cast<unsigned>(quadX) < static_cast<unsigned>(quadWidth) && static_cast<unsigned>(quadY) < static_cast<unsigned>(quadHeight)) {
+                int texelX = texelLeft + quadX * texelStepX;
+                int texelY = texelTop + quadY * texelStepY;
+                if (static_cast<unsigned>(texelX) < static_cast<unsigned>(imageWidth) && static_cast<unsigned>(texelY) < static_cast<unsigned>(imageHeight)) {
+                    texel = texels[static_cast<size_t>(texelY) * imageWidth + texelX];
+                }
+            }
+            span[i] = texel;
+        }
+
+        if (tinted) {
+            for (size_t i = 0; i < count; ++i) {
+                uint32_t texel = span[i];
+                span[i] = divide255((texel & 0xFF) * color.r)
+                    | (divide255(((texel >> 8) & 0xFF) * color.g) << 8)
+                    | (divide255(((texel >> 16) & 0xFF) * color.b) << 16)
+                    | (divide255((texel >> 24) * color.a) << 24);
+            }
+        }
+
+        blendSpan(&pixels[static_cast<size_t>(y) * width + left], span.data(), count);
+    }
+}
+
+bool Framebuffer::saveToFile(const std::string& path) const {
+    FILE* file = fopen(path.c_str(), "wb");
+    if (!file) {
+        return false;
+    }
+    fprintf(file, "P6\n%u %u\n255\n", width, height);
+    std::vector<uint8_t> row(static_cast<size_t>(width) * 3);
+    bool written = true;
+    for (unsigned y = 0; y < height && written; ++y) {
+        for (unsigned x = 0; x < width; ++x) {
+            uint32_t pixel = pixels[static_cast<size_t>(y) * width + x];
+            row[x * 3] = pixel & 0xFF;
+            row[x * 3 + 1] = (pixel >> 8) & 0xFF;
+            row[x * 3 + 2] = (pixel >> 16) & 0xFF;
+        }
+        written = fwrite(row.data(), 1, row.size(), file) == row.size();
+    }
+    return fclose(file) == 0 && written;
+}
+
+uint64_t Framebuffer::hash() const {
+    uint64_t hash = 1469598103934665603ULL;
+    for (uint32_t pixel : pixels) {
+        hash = (hash ^ pixel) * 1099511628211ULL;
+    }
+    return hash;
+}
+
+void setTextureImage(const Texture& texture, const Image& image) {
+    textureImages[&texture] = image;
+}
+
+void updateTextureImage(const Texture& texture, const Uint8* pixels) {
+    auto found = textureImages.find(&texture);
+    if (found != textureImages.end()) {
+        Vector2u size = found->second.getSize();
+        found->second.create(size.x, size.y, pixels);
+    }
+}
+
+const Image* findTextureImage(const Texture& texture) {
+    auto found = textureImages.find(&texture);
+    return (found != textureImages.end()) ? &found->second : nullptr;
+}
+
+bool loadGlyphFont(const Font& font, const std::string& path) {
+#if defined(CENTIPEDE_FREETYPE)
+    if (!freetype && FT_Init_FreeType(&freetype) != 0) {
+        freetype = nullptr;
+        return false;
+    }
+    FT_Face face = nullptr;
+    if (FT_New_Face(freetype, path.c_str(), 0, &face) != 0) {
+        return false;
+    }
+    FT_Face& loaded = glyphFaces[&font];
+    if (loaded) {
+        FT_Done_Face(loaded);
+    }
+    loaded = face;
+    return true;
+#else
+    (void)font;
+    (void)path;
+    return false;
+#endif
+}
+
+void prepareGlyphs(const Font& font, unsigned characterSize) {
+#if defined(CENTIPEDE_FREETYPE)
+    auto face = glyphFaces.find(&font);
+    if (face != glyphFaces.end() && FT_Set_Pixel_Sizes(face->second, 0, characterSize) == 0) {
+        // Rasterize every glyph first, the atlas is only sized once they are all known
+        GlyphAtlas& atlas = glyphAtlases[{&font, characterSize}];
+        std::vector<std::vector<Uint8>> coverages(glyphCount);
+        FT_Pos lsbDeltas[glyphCount] = {};
+        FT_Pos rsbDeltas[glyphCount] = {};
+        int atlasWidth = 0;
+        int atlasHeight = 1;
+        for (size_t i = 0; i < glyphCount; ++i) {
+            if (FT_Load_Char(face->second, firstGlyph + i, FT_LOAD_RENDER | FT_LOAD_FORCE_AUTOHINT) != 0) {
+                continue;
+            }
+            FT_GlyphSlot slot = face->second->glyph;
+            const FT_Bitmap& bitmap = slot->bitmap;
+            int width = static_cast<int>(bitmap.width);
+            int height = static_cast<int>(bitmap.rows);
+            SoftwareGlyph& glyph = atlas.glyphs[i];
+            glyph.advance = static_cast<float>(slot->metrics.horiAdvance) / 64.0f;
+            glyph.bounds = FloatRect(static_cast<float>(slot->bitmap_left), static_cast<float>(-slot->bitmap_top),
+                static_cast<float>(width), static_cast<float>(height));
+            glyph.textureRect = IntRect(atlasWidth, 0, width, height);
+            lsbDeltas[i] = slot->lsb_delta;
+            rsbDeltas[i] = slot->rsb_delta;
+
+            // Monochrome bitmaps hold one bit per pixel, anti-aliased ones a byte
+            std::vector<Uint8>& coverage = coverages[i];
+            coverage.resize(static_cast<size_t>(width) * height);
+            for (int row = 0; row < height; ++row) {
+                const unsigned char* source = bitmap.buffer + row * bitmap.pitch;
+                for (int column = 0; column < width; ++column) {
+                    bool mono = bitmap.pixel_mode == FT_PIXEL_MODE_MONO;
+                    coverage[row * width + column] = mono ? (((source[column / 8] >> (7 - column % 8)) & 1) ? 255 : 0) : source[column];
+                }
+            }
+            atlasWidth += width + 1;
+            atlasHeight = std::max(atlasHeight, height);
+        }
+
+        atlas.image.create(std::max(1, atlasWidth), atlasHeight, Color(255, 255, 255, 0));
+        for (size_t i = 0; i < glyphCount; ++i) {
+            const IntRect& rect = atlas.glyphs[i].textureRect;
+            for (int row = 0; row < rect.height; ++row) {
+                for (int column = 0; column < rect.width; ++column) {
+                    atlas.image.setPixel(rect.left + column, row, Color(255, 255, 255, coverages[i][row * rect.width + column]));
+                }
+            }
+        }
+
+        // Kerning in whole pixels, corrected by the autohinter's side bearing deltas as SFML does
+        atlas.kerning.assign(glyphCount * glyphCount, 0.0f);
+        if (FT_HAS_KERNING(face->second)) {
+            for (size_t first = 0; first < glyphCount; ++first) {
+                FT_UInt firstIndex = FT_Get_Char_Index(face->second, firstGlyph + first);
+                for (size_t second = 0; second < glyphCount; ++second) {
+                    FT_Vector kerning = {0, 0};
+                    FT_Get_Kerning(face->second, firstIndex, FT_Get_Char_Index(face->second, firstGlyph + second), FT_KERNING_UNFITTED, &kerning);
+                    FT_Pos adjusted = FT_IS_SCALABLE(face->second) ? kerning.x + lsbDeltas[second] - rsbDeltas[first] + 32 : kerning.x;
+                    atlas.kerning[first * glyphCount + second] = std::floor(static_cast<float>(adjusted) / 64.0f);
+                }
+            }
+        }
+        return;
+    }
+#endif
+
+    // Without FreeType the glyphs come from the font's pages, read back from SFML once
+    for (Uint32 character = ' '; character <= '~'; ++character) {
+        font.getGlyph(character, characterSize, false);
+    }
+    const Texture& page = font.getTexture(characterSize);
+    setTextureImage(page, page.copyToImage());
+}
+
+FloatRect measureText(const Text& text) {
+    // The box sf::Text::getLocalBounds() reports, spaces widening it by their advance
+    float characterSize = static_cast<float>(text.getCharacterSize());
+    float minX = characterSize;
+    float minY = characterSize;
+    float maxX = 0;
+    float maxY = 0;
+    layoutText(text, [&](const Image&, const SoftwareGlyph& glyph, Uint32 character, float x, float y) {
+        if (character == ' ') {
+            minX = std::min(minX, x);
+            minY = std::min(minY, y);
+            maxX = std::max(maxX, x + glyph.advance);
+            maxY = std::max(maxY, y);
+            return;
+        }
+        minX = std::min(minX, x + glyph.bounds.left);
+        minY = std::min(minY, y + glyph.bounds.top);
+        maxX = std::max(maxX, x + glyph.bounds.left + glyph.bounds.width);
+        maxY = std::max(maxY, y + glyph.bounds.top + glyph.bounds.height);
+    });
+    if (maxX < minX || maxY < minY) {
+        return FloatRect();
+    }
+    return FloatRect(minX, minY, maxX - minX, maxY - minY);
+}
+
+void setSimdSpans(bool simd) {
+    simdSpans = simd;
+}
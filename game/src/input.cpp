@@ -0,0 +1,102 @@
+#include "input.h"
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <cstdio>
+#include <thread>
+#include "spscQueue.h"
+
+using SteadyClock = std::chrono::steady_clock;
+
+static SpscQueue<InputEvent, 256> inputEvents; ///< Key state changes waiting to be latched.
+static std::atomic<bool> inputRunning{false}; ///< Whether the input thread should keep sampling.
+static std::thread inputThread; ///< The thread sampling the keyboard.
+static uint8_t latchedKeys = 0; ///< The key state as of the last latch.
+
+static const std::array<long, 8> latencyBucketLimits = {250, 500, 1000, 2000, 4000, 8000, 16000, 33000}; ///< Bucket upper bounds in microseconds.
+static std::array<long, 9> latencyBuckets = {}; ///< Event counts per bucket, the last one is unbounded.
+static long latencyMax = 0; ///< The largest latency observed in microseconds.
+
+/**
+ * @brief Reads the current state of every sampled key.
+ *
+ * @return uint8_t The InputKey flags currently held.
+ */
+static uint8_t sampleKeys() {
+    uint8_t keys = 0;
+    if (Keyboard::isKeyPressed(Keyboard::Left)) keys |= KEY_LEFT;
+    if (Keyboard::isKeyPressed(Keyboard::Right)) keys |= KEY_RIGHT;
+    if (Keyboard::isKeyPressed(Keyboard::Up)) keys |= KEY_UP;
+    if (Keyboard::isKeyPressed(Keyboard::Down)) keys |= KEY_DOWN;
+    if (Keyboard::isKeyPressed(Keyboard::Space)) keys |= KEY_FIRE;
+    if (Keyboard::isKeyPressed(Keyboard::Return)) keys |= KEY_START;
+    return keys;
+}
+
+/**
+ * @brief Samples the keyboard every millisecond and queues state changes.
+ */
+static void inputLoop() {
+    uint8_t lastKeys = 0;
+    bool pending = false;
+    SteadyClock::time_point nextSample = SteadyClock::now();
+
+    while (inputRunning.load(std::memory_order_relaxed)) {
+        SteadyClock::time_point now = SteadyClock::now();
+        uint8_t keys = sampleKeys();
+
+        // Only queue changes, retrying next sample if the consumer has fallen behind
+        if (keys != lastKeys || pending) {
+            pending = !inputEvents.push({keys, now});
+            lastKeys = keys;
+        }
+
+        nextSample += std::chrono::milliseconds(1);
+        std::this_thread::sleep_until(nextSample);
+    }
+}
+
+void inputInit() {
+    inputRunning = true;
+    inputThread = std::thread(inputLoop);
+}
+
+void inputShutdown() {
+    if (!inputRunning) {
+        return;
+    }
+    inputRunning = false;
+    inputThread.join();
+
+    // Print the input-to-action latency histogram
+    long total = 0;
+    for (long count : latencyBuckets) {
+        total += count;
+    }
+    printf("Input latency (%ld events, max %.2f ms):\n", total, latencyMax / 1000.0);
+    for (size_t i = 0; i < latencyBuckets.size(); ++i) {
+        if (i < latencyBucketLimits.size()) {
+            printf("  <= %6.2f ms: %ld\n", latencyBucketLimits[i] / 1000.0, latencyBuckets[i]);
+        } else {
+            printf("  >  %6.2f ms: %ld\n", latencyBucketLimits.back() / 1000.0, latencyBuckets[i]);
+        }
+    }
+}
+
+uint8_t latchInputs() {
+    SteadyClock::time_point now = SteadyClock::now();
+    InputEvent event;
+
+    // Apply every queued change in order and record how long each one waited
+    while (inputEvents.pop(event)) {
+        latchedKeys = event.keys;
+        long latency = std::chrono::duration_cast<std::chrono::microseconds>(now - event.timestamp).count();
+        latencyMax = std::max(latencyMax, latency);
+        size_t bucket = 0;
+        while (bucket < latencyBucketLimits.size() && latency > latencyBucketLimits[bucket]) {
+            bucket++;
+        }
+        latencyBuckets[bucket]++;
+    }
+    return latchedKeys;
+}
@@ -1,203 +1,190 @@
 #include "laserBlaster.h"
+#include "memoryTracker.h"
+#include "renderBackend.h"
 
 Texture laserTexture, starShipTexture;
 ECE_LaserBlaster player(0, 0, 0);
 
+static bool texturesLoaded = false; ///< Whether laserBlasterInit() has loaded the textures the ship is sized from.
+
 void laserBlasterInit() {
+    MemoryScope scope(Subsystem::TEXTURES);
+
     // Create the laser blast texture
     Image laserBlast;
     int width = 5;
     int height = 15;
     laserBlast.create(width, height, Color::Red);
-    laserTexture.loadFromImage(laserBlast);
+    loadTexture(laserTexture, laserBlast);
 
     // Load the starship texture
-    if (!starShipTexture.loadFromFile("assets/textures/StarShip.png")) {
+    if (!loadTexture(starShipTexture, "assets/textures/StarShip.png")) {
         printf("Failed to load texture from %s\n", "assets/textures/StarShip.png");
     }
+    texturesLoaded = true;
 
     // Initialize the player
     player = ECE_LaserBlaster(3, 10, 0.25f);
 }
 
-ECE_LaserBlast::ECE_LaserBlast(float blastSpeed) {
-    setTexture(laserTexture);
-    speed = blastSpeed;
-    id = globalCounter++;
-}
-
-bool ECE_LaserBlast::move() {
-    setPosition(getPosition().x, getPosition().y - speed);
-    bool remove = handleCollision();
-    return remove;
-}
-
-bool ECE_LaserBlast::handleCollision() {
-    // Handle laser blast collision with the window bounds
-    if (getPosition().y < 0 || getPosition().y > windowHeight) {
-        return true;
-    }
-
-    // Check collision with mushrooms
-    for (auto& mushroom : mushrooms) {
-        if (mushroom.getHealth() > 0 && getGlobalBounds().intersects(mushroom.getGlobalBounds())) {
-            mushroom.handleCollision();
-            return true;
-        }
-    }
-
-    // Check collision with centipede segments
-    auto& segments = centipede.getSegments();
-    for (auto it = segments.begin(); it != segments.end(); ++it) {
-        ECE_CentipedeSegment& segment = *it;
-        if (segment.getStatus() == CharacterStatus::ALIVE && getGlobalBounds().intersects(segment.getGlobalBounds())) {
-            segment.setStatus(CharacterStatus::DEAD);
-            
-            // Increment player score by 100 for head segment, 10 for body segment
-            if (segment.getType() == SegmentType::HEAD) {
-                player.incrementScore(100);
-            } else {
-                player.incrementScore(10);
-            }
-
-            // Save the iterator before tyring to change the next segment to a head
-            auto currentIt = it;
-            ++it;
-
-            // Check if the next segment exists and is alive before changing it to a head
-            if (it != segments.end() && it->getStatus() == CharacterStatus::ALIVE) {
-                ECE_CentipedeSegment& nextSegment = *it;
-                nextSegment.setType(SegmentType::HEAD);
-                nextSegment.setTexture(headTextures[nextSegment.getTextureIndex()]);
-            }
-
-            // Spawn a mushroom at the location of the destroyed segment
-            addMushroom(segment.getPosition().x, segment.getPosition().y);
-
-            return true;
-        }
-    }
-
-    // Check collision with spider and increment player score by 500 on hit
-    if (spider.getStatus() == CharacterStatus::ALIVE && spider.getGlobalBounds().intersects(getGlobalBounds())) {
-        spider.handleCollision();
-        player.incrementScore(500);
-        return true;
-    }
-
-    return false;
-}
-
 ECE_LaserBlaster::ECE_LaserBlaster(float speed, float blastSpeed, float reloadTime) {
-    this->speed = speed;
-    this->blastSpeed = blastSpeed;
+    this->speed = fromFloat(speed);
+    this->blastSpeed = fromFloat(blastSpeed);
     lives = 3;
     score = 0;
     highScore = 0;
-    shotDelay = reloadTime;
-    shotClock.restart();
-    setTexture(starShipTexture);
-    setPosition(windowWidth / 2, windowHeight - 2 * getGlobalBounds().height);
+    reloadTicks = secondsToTicks(reloadTime);
+
+    // The global player is constructed before the textures are loaded, and sized once laserBlasterInit() replaces it
+    Vector2u size = texturesLoaded ? getTextureSize(starShipTexture) : Vector2u();
+    ship = entities.create();
+    entities.placements.insert(ship, {});
+    entities.colliders.insert(ship, {toFixed(size.x), toFixed(size.y)});
+    entities.renderables.insert(ship, {&starShipTexture});
+    resetPosition();
 }
 
 void ECE_LaserBlaster::shoot() {
-    // Check if the reload time has passed
-    if (shotClock.getElapsedTime().asSeconds() < shotDelay) {
+    // Check if the blaster is still reloading
+    if (reloadTimer.isPending()) {
         return;
     }
 
-    // Reset the reload cooldown and fire a new blast
-    shotClock.restart();
-    ECE_LaserBlast blast(blastSpeed);
-    blast.setPosition(getPosition().x + 0.5 * getGlobalBounds().width - 0.5 * laserTexture.getSize().x, getPosition().y);
-    blasts.push_back(blast);
+    // Start the reload cooldown and fire a new blast
+    MemoryScope scope(Subsystem::LASER);
+    gameTimers.schedule(reloadTimer, reloadTicks);
+    Vector2u size = getTextureSize(laserTexture);
+    FixedVec position = getFixedPosition();
+    Entity blast = blasts.create();
+    blasts.placements.insert(blast, {{position.x + (getFixedBounds().width - toFixed(size.x)) / 2, position.y}});
+    blasts.colliders.insert(blast, {toFixed(size.x), toFixed(size.y)});
+    blasts.renderables.insert(blast, {&laserTexture});
+    blasts.motions.insert(blast, {0, -1, blastSpeed});
 }
 
 void ECE_LaserBlaster::update(Direction direction) {
-    Vector2f position = getPosition();
-    FloatRect bounds = getGlobalBounds();
+    MemoryScope scope(Subsystem::LASER);
+    FixedVec& position = entities.placements.get(ship)->position;
+    FixedRect bounds = getFixedBounds();
 
     // Lambda function to check for collision with mushrooms
-    auto mushroomCollision = [&](Vector2f newPos) {
-        FloatRect newBounds(newPos.x, newPos.y, bounds.width, bounds.height);
-        for (auto& mushroom : mushrooms) {
-            if (mushroom.getHealth() > 0 && mushroom.getGlobalBounds().intersects(newBounds)) {
-                return true;
-            }
-        }
-        return false;
-    };
-
-    // Lambda function to check for collision with centipede segments
-    auto centipedeCollision = [&]() {
-        for (auto& segment : centipede.getSegments()) {
-            if (segment.getStatus() == CharacterStatus::ALIVE && getGlobalBounds().intersects(segment.getGlobalBounds())) {
-                return true;
-            }
-        }
-        return false;
-    };
-
-    // Lambda function to check for collision with the spider
-    auto spiderCollision = [&]() {
-        if (spider.getStatus() == CharacterStatus::ALIVE && spider.getGlobalBounds().intersects(getGlobalBounds())) {
-            return true;
-        }
-        return false;
+    const BoxArray& mushroomBoxes = getMushroomBoxes();
+    auto mushroomCollision = [&](FixedVec newPos) {
+        FixedRect newBounds = {newPos.x, newPos.y, bounds.width, bounds.height};
+        return mushroomBoxes.firstHit(newBounds) < mushroomBoxes.size();
     };
 
     // Process movement based on input direction
     switch (direction) {
         case Direction::UP:
-            if (position.y - speed >= 0.5f * windowHeight && !mushroomCollision({position.x, position.y - speed})) {
-                setPosition(position.x, position.y - speed);
+            if (position.y - speed >= toFixed(windowHeight) / 2 && !mushroomCollision({position.x, position.y - speed})) {
+                position.y -= speed;
             }
             break;
         case Direction::DOWN:
-            if (position.y + bounds.height + speed <= windowHeight && 
+            if (position.y + bounds.height + speed <= toFixed(windowHeight) && 
                 !mushroomCollision({position.x, position.y + speed})) {
-                setPosition(position.x, position.y + speed);
+                position.y += speed;
             }
             break;
         case Direction::LEFT:
             if (position.x - speed >= 0 && !mushroomCollision({position.x - speed, position.y})) {
-                setPosition(position.x - speed, position.y);
+                position.x -= speed;
             }
             break;
         case Direction::RIGHT:
-            if (position.x + bounds.width + speed <= windowWidth &&
+            if (position.x + bounds.width + speed <= toFixed(windowWidth) &&
                 !mushroomCollision({position.x + speed, position.y})) {
-                setPosition(position.x + speed, position.y);
+                position.x += speed;
             }
             break;
         case Direction::NONE:
         default:
             break;
     }
+}
+
+void ECE_LaserBlaster::detectPlayerHit(CollisionQueue& events) {
+    FixedRect bounds = getFixedBounds();
+
+    // Lambda function to check for collision with centipede segments
+    auto centipedeCollision = [&]() {
+        const BoxArray& segmentBoxes = centipede.getSegmentBoxes();
+        return segmentBoxes.firstHit(bounds) < segmentBoxes.size();
+    };
+
+    // Lambda function to check for collision with the spider
+    auto spiderCollision = [&]() {
+        if (spider.getStatus() == CharacterStatus::ALIVE && spider.getFixedBounds().intersects(bounds)) {
+            return true;
+        }
+        return false;
+    };
 
     // Check for collision with centipede or spider
     if (centipedeCollision() || spiderCollision()) {
-        player.decrementLives();
-        centipede.reset(false);
-        resetPosition();
+        events.push({CollisionKind::PLAYER_HIT, Entity{}, Entity{}});
     }
+}
+
+void ECE_LaserBlaster::detectBlastHits(CollisionQueue& events) {
+    const BoxArray& mushroomBoxes = getMushroomBoxes();
+    const BoxArray& segmentBoxes = centipede.getSegmentBoxes();
+    for (size_t i = 0; i < blasts.motions.size(); ++i) {
+        Entity blast = blasts.motions.entityAt(i);
+        FixedRect bounds = blasts.getBounds(blast);
+
+        // Check collision with mushrooms
+        size_t mushroomHit = mushroomBoxes.firstHit(bounds);
+        if (mushroomHit < mushroomBoxes.size()) {
+            events.push({CollisionKind::BLAST_MUSHROOM, blast, mushrooms.entityAt(mushroomBoxes.getId(mushroomHit))});
+            continue;
+        }
+
+        // Check collision with centipede segments
+        size_t segmentHit = segmentBoxes.firstHit(bounds);
+        if (segmentHit < segmentBoxes.size()) {
+            events.push({CollisionKind::BLAST_SEGMENT, blast, centipede.getSegments().entityAt(segmentBoxes.getId(segmentHit))});
+            continue;
+        }
 
-    // Update the laser blasts and handle collisions
-    for (auto it = blasts.begin(); it != blasts.end();) {
-        bool remove = it->move();
-        if (remove) {
-            it = blasts.erase(it);
+        // Check collision with spider
+        if (spider.getStatus() == CharacterStatus::ALIVE && spider.getFixedBounds().intersects(bounds)) {
+            events.push({CollisionKind::BLAST_SPIDER, blast, Entity{}});
+        }
+    }
+}
+
+void ECE_LaserBlaster::loseLife() {
+    decrementLives();
+    centipede.reset(false);
+    resetPosition();
+}
+
+void ECE_LaserBlaster::moveBlasts() {
+    MemoryScope scope(Subsystem::LASER);
+    for (size_t i = 0; i < blasts.motions.size();) {
+        Entity blast = blasts.motions.entityAt(i);
+        const Motion& motion = blasts.motions[i];
+        FixedVec& position = blasts.placements.get(blast)->position;
+        position.x += motion.dx * motion.speed;
+        position.y += motion.dy * motion.speed;
+
+        // Remove the laser blast once it leaves the window bounds, the last blast moving into its place
+        if (position.y < 0 || position.y > toFixed(windowHeight)) {
+            blasts.destroy(blast);
         } else {
-            ++it;
+            ++i;
         }
     }
 }
 
 void ECE_LaserBlaster::resetPosition() {
-    setPosition(windowWidth / 2, windowHeight - 2 * getGlobalBounds().height);
+    entities.placements.get(ship)->position = {toFixed(windowWidth) / 2, toFixed(windowHeight) - 2 * getFixedBounds().height};
 }
 
 void ECE_LaserBlaster::reset() {
+    reloadTimer.cancel();
     blasts.clear();
     resetScore();
     resetLives();
@@ -205,8 +192,8 @@ void ECE_LaserBlaster::reset() {
 }
 
 void ECE_LaserBlaster::draw() {
-    window.draw(*this);
-    for (auto& blast : blasts) {
-        window.draw(blast);
-    }
+    batch.clear();
+    batchEntities(entities, batch);
+    batchEntities(blasts, batch);
+    drawBatch(batch);
 }
\ No newline at end of file
@@ -0,0 +1,191 @@
+#include "levelFile.h"
+#include <algorithm>
+#include <cstdio>
+#include <cstring>
+#include "globals.h"
+#include "memoryTracker.h"
+#include "mushroom.h"
+#include "renderBackend.h"
+#if defined(__unix__) || defined(__APPLE__)
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#define LEVELFILE_MMAP
+#endif
+
+static const char levelMagic[4] = {'C', 'P', 'L', 'V'}; ///< The magic at the start of every level file.
+static const uint32_t levelVersion = 1; ///< The format version written by saveLevel().
+
+static const char* levelPath = nullptr; ///< The level given with --level.
+static const char* saveLevelPath = nullptr; ///< The file given with --save-level.
+static LevelFile configuredLevel; ///< The level given with --level, kept open once loaded.
+
+bool LevelFile::open(const char* path) {
+    close();
+
+#if defined(LEVELFILE_MMAP)
+    int fd = ::open(path, O_RDONLY);
+    if (fd < 0) {
+        printf("Failed to open level %s\n", path);
+        return false;
+    }
+    struct stat info;
+    if (fstat(fd, &info) != 0 || info.st_size < static_cast<off_t>(sizeof(LevelHeader))) {
+        printf("Level %s is too short\n", path);
+        ::close(fd);
+        return false;
+    }
+    void* mapping = mmap(nullptr, info.st_size, PROT_READ, MAP_SHARED, fd, 0);
+    // The mapping stays valid after the descriptor is closed
+    ::close(fd);
+    if (mapping == MAP_FAILED) {
+        printf("Failed to map level %s\n", path);
+        return false;
+    }
+    data = static_cast<const uint8_t*>(mapping);
+    size = static_cast<size_t>(info.st_size);
+    mapped = true;
+#else
+    FILE* file = fopen(path, "rb");
+    if (!file) {
+        printf("Failed to open level %s\n", path);
+        return false;
+    }
+    fseek(file, 0, SEEK_END);
+    long length = ftell(file);
+    fseek(file, 0, SEEK_SET);
+    buffer.resize((length > 0) ? static_cast<size_t>(length) : 0);
+    bool read = length >= static_cast<long>(sizeof(LevelHeader)) && fread(buffer.data(), 1, buffer.size(), file) == buffer.size();
+    fclose(file);
+    if (!read) {
+        printf("Level %s is too short\n", path);
+        buffer.clear();
+        return false;
+    }
+    data = buffer.data();
+    size = buffer.size();
+#endif
+
+    // Validate the header and make sure every cell is present
+    memcpy(&header, data, sizeof(LevelHeader));
+    uint64_t cells = static_cast<uint64_t>(header.columns) * header.rows;
+    if (memcmp(header.magic, levelMagic, sizeof(levelMagic)) != 0 || header.version != levelVersion) {
+        printf("%s is not a version %u level\n", path, levelVersion);
+        close();
+        return false;
+    }
+    if (header.cellWidth == 0 || header.cellHeight == 0 || sizeof(LevelHeader) + cells > size) {
+        printf("Level %s is truncated or malformed\n", path);
+        close();
+        return false;
+    }
+
+    // Cells past the fixed-point range could never be placed, whatever the window size
+    uint64_t fieldWidth = static_cast<uint64_t>(header.columns) * header.cellWidth;
+    uint64_t fieldHeight = static_cast<uint64_t>(header.rows) * header.cellHeight;
+    if (fieldWidth > static_cast<uint64_t>(FIXED_MAX_PIXELS) || fieldHeight > static_cast<uint64_t>(FIXED_MAX_PIXELS)) {
+        printf("Level %s is %llux%llu pixels, larger than the playfield can hold\n", path,
+            static_cast<unsigned long long>(fieldWidth), static_cast<unsigned long long>(fieldHeight));
+        close();
+        return false;
+    }
+    return true;
+}
+
+void LevelFile::close() {
+#if defined(LEVELFILE_MMAP)
+    if (mapped) {
+        munmap(const_cast<uint8_t*>(data), size);
+    }
+#endif
+    buffer.clear();
+    data = nullptr;
+    size = 0;
+    mapped = false;
+}
+
+void LevelFile::apply() const {
+    MemoryScope scope(Subsystem::MUSHROOM);
+    clearMushrooms();
+    const uint8_t* cells = getCells();
+
+    // A level saved with a larger window keeps only the cells that fit entirely in this one
+    uint32_t columns = std::min<uint32_t>(header.columns, static_cast<uint32_t>(std::max(0, windowWidth)) / header.cellWidth);
+    uint32_t rows = std::min<uint32_t>(header.rows, static_cast<uint32_t>(std::max(0, windowHeight)) / header.cellHeight);
+    for (uint32_t row = 0; row < rows; ++row) {
+        for (uint32_t column = 0; column < columns; ++column) {
+            uint8_t health = cells[static_cast<size_t>(row) * header.columns + column];
+            if (health != 0) {
+                addMushroom(column * header.cellWidth, row * header.cellHeight, std::min<int>(health, 2));
+            }
+        }
+    }
+}
+
+bool saveLevel(const char* path) {
+    LevelHeader header;
+    memcpy(header.magic, levelMagic, sizeof(levelMagic));
+    header.version = levelVersion;
+    header.cellWidth = getTextureSize(normalMushroomTexture).x;
+    header.cellHeight = getTextureSize(normalMushroomTexture).y;
+    header.columns = (header.cellWidth > 0) ? windowWidth / header.cellWidth : 0;
+    header.rows = (header.cellHeight > 0) ? windowHeight / header.cellHeight : 0;
+
+    // Snap every mushroom with health left to the cell its center is in
+    std::vector<uint8_t> cells(static_cast<size_t>(header.columns) * header.rows, 0);
+    for (size_t i = 0; i < mushrooms.healths.size(); ++i) {
+        int health = mushrooms.healths[i].hitPoints;
+        FixedRect bounds = getMushroomBounds(mushrooms.healths.entityAt(i));
+        int column = toPixels(bounds.left + bounds.width / 2) / static_cast<int>(header.cellWidth);
+        int row = toPixels(bounds.top + bounds.height / 2) / static_cast<int>(header.cellHeight);
+        if (health <= 0 || column < 0 || row < 0 || column >= static_cast<int>(header.columns) || row >= static_cast<int>(header.rows)) {
+            continue;
+        }
+        uint8_t& cell = cells[static_cast<size_t>(row) * header.columns + column];
+        cell = std::max(cell, static_cast<uint8_t>(std::min(health, 255)));
+    }
+
+    FILE* file = fopen(path, "wb");
+    if (!file) {
+        printf("Failed to write level %s\n", path);
+        return false;
+    }
+    bool written = fwrite(&header, sizeof(header), 1, file) == 1 && fwrite(cells.data(), 1, cells.size(), file) == cells.size();
+    written = (fclose(file) == 0) && written;
+    if (!written) {
+        printf("Failed to write level %s\n", path);
+    }
+    return written;
+}
+
+void parseLevelArgs(int argc, char* argv[]) {
+    for (int i = 1; i + 1 < argc; ++i) {
+        if (strcmp(argv[i], "--level") == 0) {
+            levelPath = argv[++i];
+        } else if (strcmp(argv[i], "--save-level") == 0) {
+            saveLevelPath = argv[++i];
+        }
+    }
+}
+
+bool applyConfiguredLevel() {
+    if (!levelPath) {
+        return false;
+    }
+
+    // Open the level once, later games reuse the mapping
+    if (!configuredLevel.isOpen() && !configuredLevel.open(levelPath)) {
+        printf("Falling back to generated mushroom fields\n");
+        levelPath = nullptr;
+        return false;
+    }
+    configuredLevel.apply();
+    return true;
+}
+
+void saveConfiguredLevel() {
+    if (saveLevelPath && saveLevel(saveLevelPath)) {
+        printf("Level written to %s\n", saveLevelPath);
+    }
+}
@@ -1,15 +1,31 @@
 #include <iostream>
-#include <sstream>
 #include <vector>
-#include <iomanip>
-#include <locale>
 #include <array>
+#include <string>
+#include <cstring>
+#include <memory_resource>
 #include <SFML/Graphics.hpp>
 #include "mushroom.h"
 #include "laserBlaster.h"
 #include "centipede.h"
 #include "spider.h"
 #include "globals.h"
+#include "input.h"
+#include "simulation.h"
+#include "taskGraph.h"
+#include "soak.h"
+#include "bench.h"
+#include "framePacer.h"
+#include "fieldLayer.h"
+#include "frameArena.h"
+#include "memoryTracker.h"
+#include "animation.h"
+#include "levelFile.h"
+#include "fieldStream.h"
+#include "renderBackend.h"
+#include "telemetry.h"
+#include "textureVariants.h"
+#include "collisionEvents.h"
 
 using namespace sf;
 
@@ -19,51 +35,47 @@ Sprite startupSprite;
 Texture backgroundTexture;
 Sprite backgroundSprite;
 
-Texture backgroundTextures[3]; ///< Background texture variants.
-Texture starShipTextures[3]; ///< Starship texture variants.
-Texture laserTextures[3]; ///< Laser texture variants.
-Texture normalMushroomTextures[3]; ///< Normal mushroom texture variants.
-Texture damagedMushroomTextures[3]; ///< Damaged mushroom texture variants.
-std::vector<std::array<Texture, 3>> headTexturesVariants; ///< Head texture variants.
-std::vector<std::array<Texture, 3>> bodyTexturesVariants; ///< Body texture variants.
-std::vector<std::array<Texture, 3>> spiderTexturesVariants; ///< Spider texture variants.
-
-int globalCounter = 0; ///< Global counter for creating unique IDs.
-int colorSwapIndex = 0; ///< Index for the current color variant.
 int windowWidth = 1080;
 int windowHeight = 680;
 
 /**
- * @brief Captures keyboard inputs and returns the corresponding direction.
- *
- * @return Direction The direction corresponding to the pressed arrow key, or Direction::NONE if no arrow key is pressed.
+ * @brief Formats a number into a string with commas.
+ * 
+ * @param number The number to format.
+ * @return std::pmr::string The formatted number, allocated from the frame arena.
  */
-Direction getInputs() {
-    if (Keyboard::isKeyPressed(Keyboard::Left)) {
-        return Direction::LEFT;
-    }
-    else if (Keyboard::isKeyPressed(Keyboard::Right)) {
-        return Direction::RIGHT;
-    }
-    else if (Keyboard::isKeyPressed(Keyboard::Up)) {
-        return Direction::UP;
-    }
-    else if (Keyboard::isKeyPressed(Keyboard::Down)) {
-        return Direction::DOWN;
+std::pmr::string formatWithCommas(int number) {
+    std::pmr::string digits(frameArena());
+    unsigned int magnitude = (number < 0) ? -static_cast<unsigned int>(number) : number;
+
+    // Emit digits least significant first, inserting a comma between every group of three
+    int count = 0;
+    do {
+        if (count > 0 && count % 3 == 0) {
+            digits.push_back(',');
+        }
+        digits.push_back(static_cast<char>('0' + magnitude % 10));
+        magnitude /= 10;
+        count++;
+    } while (magnitude > 0);
+    if (number < 0) {
+        digits.push_back('-');
     }
-    return Direction::NONE;
+    return std::pmr::string(digits.rbegin(), digits.rend(), frameArena());
 }
 
 /**
- * @brief Formats a number into a string with commas.
+ * @brief Sets a text element to a label followed by a number formatted with commas.
  * 
+ * @param text The text element to update.
+ * @param label The label preceding the number.
  * @param number The number to format.
  */
-std::string formatWithCommas(int number) {
-    std::stringstream ss;
-    ss.imbue(std::locale(""));
-    ss << std::fixed << std::setprecision(0) << number;
-    return ss.str();
+void setNumberText(Text& text, const char* label, int number) {
+    MemoryScope scope(Subsystem::HUD);
+    std::pmr::string str(label, frameArena());
+    str += formatWithCommas(number);
+    text.setString(str.c_str());
 }
 
 /**
@@ -71,21 +83,24 @@ std::string formatWithCommas(int number) {
  *
  * @param livesSprites A reference to a vector of Sprite objects representing the life sprites.
  * @param totalWidth A reference to a float that will store the total width of all life sprites.
+ * @param totalLives The number of lives to show.
  */
-void updateLifeSprites(std::vector<Sprite>& livesSprites, float& totalWidth) {
+void updateLifeSprites(std::vector<Sprite>& livesSprites, float& totalWidth, int totalLives) {
+    MemoryScope scope(Subsystem::HUD);
     livesSprites.clear();
-    int totalLives = player.getLives();
     totalWidth = 0;
 
     for (int i = 0; i < totalLives; ++i) {
-        Sprite lifeSprite(starShipTextures[colorSwapIndex]);
+        Sprite lifeSprite;
+        setSpriteTexture(lifeSprite, starShipTexture);
         totalWidth += lifeSprite.getGlobalBounds().width;
     }
 
     float startX = windowWidth - totalWidth;
 
     for (int i = 0; i < totalLives; ++i) {
-        Sprite lifeSprite(starShipTextures[colorSwapIndex]);
+        Sprite lifeSprite;
+        setSpriteTexture(lifeSprite, starShipTexture);
         lifeSprite.setPosition(startX + i * lifeSprite.getGlobalBounds().width - 10, 0);
         livesSprites.push_back(lifeSprite);
     }
@@ -98,86 +113,28 @@ void updateLifeSprites(std::vector<Sprite>& livesSprites, float& totalWidth) {
  */
 void drawLives(const std::vector<Sprite>& livesSprites) {
     for (const auto& lifeSprite : livesSprites) {
-        window.draw(lifeSprite);
+        drawSprite(lifeSprite);
     }
 }
 
 /**
- * @brief Rotates the RGB values of all pixels in a texture.
- *
- * @param texture The texture whose color channels will be swapped.
- */
-void swapRGB(Texture& texture) {
-    Image image = texture.copyToImage();
-    Vector2u size = image.getSize();
-
-    for (unsigned int y = 0; y < size.y; ++y) {
-        for (unsigned int x = 0; x < size.x; ++x) {
-            Color color = image.getPixel(x, y);
-            Color newColor(color.b, color.r, color.g, color.a);
-            image.setPixel(x, y, newColor);
-        }
-    }
-
-    texture.update(image);
-}
-
-/**
- * @brief Creates texture variants for different game elements by swapping their RGB values.
+ * @brief Registers every game texture for color variants, which are built when first needed.
  */
 void createTextureVariants() {
-    headTexturesVariants.resize(headTextures.size());
-    bodyTexturesVariants.resize(bodyTextures.size());
-    spiderTexturesVariants.resize(spiderTextures.size());
-
-    for (int i = 0; i < headTextures.size(); ++i) {
-        headTexturesVariants[i] = {headTextures[i]};
-        for (int j = 1; j < 3; ++j) {
-            Texture variant = (j > 0) ? headTexturesVariants[i][j - 1] : headTexturesVariants[i][0];
-            swapRGB(variant);
-            headTexturesVariants[i][j] = variant;
-        }
+    for (Texture& texture : headTextures) {
+        addTextureVariants(texture);
     }
-
-    for (int i = 0; i < bodyTextures.size(); ++i) {
-        bodyTexturesVariants[i] = {bodyTextures[i]};
-        for (int j = 1; j < 3; ++j) {
-            Texture variant = (j > 0) ? bodyTexturesVariants[i][j - 1] : bodyTexturesVariants[i][0];
-            swapRGB(variant);
-            bodyTexturesVariants[i][j] = variant;
-        }
+    for (Texture& texture : bodyTextures) {
+        addTextureVariants(texture);
     }
-
-    for (int i = 0; i < spiderTextures.size(); ++i) {
-        spiderTexturesVariants[i] = {spiderTextures[i]};
-        for (int j = 1; j < 3; ++j) {
-            Texture variant = (j > 0) ? spiderTexturesVariants[i][j - 1] : spiderTexturesVariants[i][0];
-            swapRGB(variant);
-            spiderTexturesVariants[i][j] = variant;
-        }
-    }
-
-    for (int i = 0; i < 3; ++i) {
-        Texture backgroundTextureVariant = (i > 0) ? backgroundTextures[i - 1] : backgroundTexture;
-        if (i > 0) swapRGB(backgroundTextureVariant);
-        backgroundTextures[i] = backgroundTextureVariant;
-
-        Texture starShipVariant = (i > 0) ? starShipTextures[i - 1] : starShipTexture;
-        if (i > 0) swapRGB(starShipVariant);
-        starShipTextures[i] = starShipVariant;
-
-        Texture laserVariant = (i > 0) ? laserTextures[i - 1] : laserTexture;
-        if (i > 0) swapRGB(laserVariant);
-        laserTextures[i] = laserVariant;
-
-        Texture normalMushroomVariant = (i > 0) ? normalMushroomTextures[i - 1] : normalMushroomTexture;
-        if (i > 0) swapRGB(normalMushroomVariant);
-        normalMushroomTextures[i] = normalMushroomVariant;
-
-        Texture damagedMushroomVariant = (i > 0) ? damagedMushroomTextures[i - 1] : damagedMushroomTexture;
-        if (i > 0) swapRGB(damagedMushroomVariant);
-        damagedMushroomTextures[i] = damagedMushroomVariant;
+    for (Texture& texture : spiderTextures) {
+        addTextureVariants(texture);
     }
+    addTextureVariants(backgroundTexture);
+    addTextureVariants(starShipTexture);
+    addTextureVariants(laserTexture);
+    addTextureVariants(normalMushroomTexture);
+    addTextureVariants(damagedMushroomTexture);
 }
 
 /**
@@ -187,93 +144,118 @@ void createTextureVariants() {
  *              the function will use the next color variant in the sequence.
  */
 void rotateAllTextureColors(int index=-1) {
-    colorSwapIndex = (index != -1) ? index : (colorSwapIndex + 1) % 3;
+    MemoryScope scope(Subsystem::TEXTURES);
+    selectTextureVariant((index != -1) ? index : (getTextureVariant() + 1) % textureVariantCount);
 
-    for (int i = 0; i < headTextures.size(); ++i) {
-        headTextures[i] = headTexturesVariants[i][colorSwapIndex];
-    }
-    for (int i = 0; i < bodyTextures.size(); ++i) {
-        bodyTextures[i] = bodyTexturesVariants[i][colorSwapIndex];
-    }
-    for (int i = 0; i < spiderTextures.size(); ++i) {
-        spiderTextures[i] = spiderTexturesVariants[i][colorSwapIndex];
-    }
-    starShipTexture = starShipTextures[colorSwapIndex];
-    laserTexture = laserTextures[colorSwapIndex];
-    normalMushroomTexture = normalMushroomTextures[colorSwapIndex];
-    damagedMushroomTexture = damagedMushroomTextures[colorSwapIndex];
-    backgroundTexture = backgroundTextures[colorSwapIndex];
+    // The cached field layer was composited with the previous colors
+    invalidateFieldLayer();
 }
 
 /**
  * @brief Resets all texture colors to their initial state.
  */
 void resetAllTextureColors() {
-    if (colorSwapIndex == 0) return;
-    colorSwapIndex = 0;
-    rotateAllTextureColors(colorSwapIndex);
+    if (getTextureVariant() == 0) return;
+    rotateAllTextureColors(0);
 }
 
-int main() {
-    // Create the window
-    window.create(VideoMode(windowWidth, windowHeight), "Centipede", Style::Default);
+int main(int argc, char* argv[]) {
+    // Apply the mushroom field and level options to every mode
+    parseMushroomArgs(argc, argv);
+    parseLevelArgs(argc, argv);
+    parseFieldStreamArgs(argc, argv);
+    parseRenderArgs(argc, argv);
+    parseTelemetryArgs(argc, argv);
+    parseSimulationArgs(argc, argv);
+    telemetryInit();
+
+    // Run the headless soak test instead of the game if requested
+    SoakConfig soakConfig;
+    if (parseSoakArgs(argc, argv, soakConfig)) {
+        int status = runSoak(soakConfig);
+        telemetryShutdown();
+        return status;
+    }
+
+    // Run a headless benchmark instead of the game if requested
+    BenchConfig benchConfig;
+    if (parseBenchArgs(argc, argv, benchConfig)) {
+        int status = runBench(benchConfig);
+        telemetryShutdown();
+        return status;
+    }
+
+    // Write the frame task graph to a DOT file on exit if requested
+    const char* taskGraphPath = nullptr;
+    for (int i = 1; i + 1 < argc; ++i) {
+        if (strcmp(argv[i], "--dump-task-graph") == 0) {
+            taskGraphPath = argv[i + 1];
+        }
+    }
+
+    // Create the window, or with the software backend the framebuffer that stands in for it
+    const RenderConfig& renderConfig = getRenderConfig();
+    bool headless = isSoftwareRendering();
+    if (headless) {
+        framebuffer.create(windowWidth, windowHeight);
+    } else {
+        window.create(VideoMode(windowWidth, windowHeight), "Centipede", Style::Default);
+    }
 
     // Load the github logo
-    if (!startupLogo.loadFromFile("assets/textures/StartupLogo.png")) {
+    if (!loadTexture(startupLogo, "assets/textures/StartupLogo.png")) {
         printf("Failed to load texture from %s\n", "assets/textures/StartupLogo.png");
         return -1;
     }
     // Scale and position the startup logo
-    startupSprite.setTexture(startupLogo);
-    float widthScale = static_cast<float>(windowWidth) / startupLogo.getSize().x;
-    float heightScale = static_cast<float>(windowHeight) / startupLogo.getSize().y;
+    setSpriteTexture(startupSprite, startupLogo);
+    float widthScale = static_cast<float>(windowWidth) / getTextureSize(startupLogo).x;
+    float heightScale = static_cast<float>(windowHeight) / getTextureSize(startupLogo).y;
     FloatRect startupBounds = startupSprite.getLocalBounds();
     startupSprite.setOrigin(0.5f * startupBounds.width, 0.5f * startupBounds.height);
     startupSprite.setScale(std::min(widthScale, heightScale), std::min(widthScale, heightScale));
     startupSprite.setPosition(0.5f * windowWidth, 0.5f * windowHeight);
 
     // Display the startup logo
-    window.clear();
-    window.draw(startupSprite);
-    window.display();
-    Event event;
-    window.pollEvent(event);
+    beginFrame();
+    drawSprite(startupSprite);
+    if (!headless) {
+        window.display();
+        Event event;
+        window.pollEvent(event);
+    }
 
     // Load the background texture
-    if (!backgroundTexture.loadFromFile("assets/textures/DirtBackground.png")) {
+    if (!loadTexture(backgroundTexture, "assets/textures/DirtBackground.png")) {
         printf("Failed to load texture from %s\n", "assets/textures/DirtBackground.png");
         return -1;
     }
 
     // Scale the background texture
-    backgroundSprite.setTexture(backgroundTexture);
+    setSpriteTexture(backgroundSprite, backgroundTexture);
     backgroundSprite.setScale(
-        static_cast<float>(windowWidth) / backgroundTexture.getSize().x,
-        static_cast<float>(windowHeight) / backgroundTexture.getSize().y
+        static_cast<float>(windowWidth) / getTextureSize(backgroundTexture).x,
+        static_cast<float>(windowHeight) / getTextureSize(backgroundTexture).y
     );
 
-    // Game timing variables
-    Clock clock;
-    const float targetFrameTime = 1.0f / 60.0f;
-    float deltaTime;
+    // Pace frames to 60 FPS, waiting after each frame is presented
+    FramePacer framePacer(1.0 / 60.0);
 
     // The current screen being displayed
     Screen currentScreen = Screen::HOME;
 
     // Initialize the game elements
-    int centipedeLength = 12;
-    int initialCentipedeSpeed = 2;
-    centipedeInit(centipedeLength, initialCentipedeSpeed);
-    mushroomInit();
-    laserBlasterInit();
-    int initialSpiderSpeed = 2;
-    spiderInit(initialSpiderSpeed);
+    initGameElements();
 
     // Generate texture color variants for all game textures
     createTextureVariants();
 
+    // Cache the background and mushroom field as a single layer
+    fieldLayerInit(backgroundSprite);
+
     // Initialize the text elements
-    std::stringstream str;
+    int displayedScore = -1;
+    int displayedHighScore = -1;
     Text scoreText;
     Text highScoreText;
     Text livesLabelText;
@@ -282,10 +264,14 @@ int main() {
 
     // Load the font
     Font font;
-    if (!font.loadFromFile("assets/fonts/KOMIKAP_.ttf")) {
+    if (!loadFont(font, "assets/fonts/KOMIKAP_.ttf")) {
         printf("Failed to load font from %s\n", "assets/fonts/KOMIKAP_.ttf");
         return -1;
     }
+    if (headless) {
+        prepareGlyphs(font, 30);
+        prepareGlyphs(font, 50);
+    }
 
     // Initialize all text elements
     highScoreText.setFont(font);
@@ -295,7 +281,7 @@ int main() {
     messageText.setFont(font);
     std::vector<Sprite> livesSprites;
     float totalLivesWidth;
-    updateLifeSprites(livesSprites, totalLivesWidth);
+    updateLifeSprites(livesSprites, totalLivesWidth, player.getLives());
 
     highScoreText.setString("High Score: 0");
     scoreText.setString("Score: 0");
@@ -315,140 +301,195 @@ int main() {
     titleText.setFillColor(Color::White);
     messageText.setFillColor(Color::Green);
 
-    FloatRect highScoreBounds = highScoreText.getLocalBounds();
+    FloatRect highScoreBounds = getTextBounds(highScoreText);
     highScoreText.setOrigin(0, 0.5f * highScoreBounds.height);
     highScoreText.setPosition(10, 10);
 
-    FloatRect scoreBounds = scoreText.getLocalBounds();
+    FloatRect scoreBounds = getTextBounds(scoreText);
     scoreText.setOrigin(0.5f * scoreBounds.width, 0.5f * scoreBounds.height);
     scoreText.setPosition(0.5f * windowWidth, 10);
 
-    FloatRect livesLabelBounds = livesLabelText.getLocalBounds();
+    FloatRect livesLabelBounds = getTextBounds(livesLabelText);
     livesLabelText.setOrigin(0, 0.5f * livesLabelBounds.height);
     livesLabelText.setPosition(windowWidth - totalLivesWidth - livesLabelBounds.width - 10, 10);
 
-    FloatRect titleBounds = titleText.getLocalBounds();
+    FloatRect titleBounds = getTextBounds(titleText);
     titleText.setOrigin(0.5f * titleBounds.width, 0.5f * titleBounds.height);
     titleText.setPosition(0.5f * windowWidth, 0.33f * windowHeight);
 
-    FloatRect messageBounds = messageText.getLocalBounds();
+    FloatRect messageBounds = getTextBounds(messageText);
     messageText.setOrigin(0.5f * messageBounds.width, 0.5f * messageBounds.height);
     messageText.setPosition(0.5f * windowWidth, 0.66f * windowHeight);
 
-    // Main game loop
-    while (window.isOpen()) {
+    // Build the GAME frame's task graph once, the HUD reading a snapshot taken before the tick
+    uint8_t frameKeys = 0;
+    GameTickResult frameResult = {false, false};
+    int hudScore = 0;
+    int hudHighScore = 0;
+    int hudLives = 0;
+    TaskGraph frameGraph;
+    frameGraph.addTask("hud", 0, RES_HUD | RES_FRAME_ARENA, [&] {
+        // Update text elements, only rebuilding the strings when the values they show have changed
+        if (hudScore != displayedScore) {
+            displayedScore = hudScore;
+            setNumberText(scoreText, "Score: ", displayedScore);
+        }
+        if (hudHighScore != displayedHighScore) {
+            displayedHighScore = hudHighScore;
+            setNumberText(highScoreText, "High Score: ", displayedHighScore);
+        }
+        updateLifeSprites(livesSprites, totalLivesWidth, hudLives);
+    });
+    addGameTasks(frameGraph, frameKeys, frameResult);
+
+    // Start sampling inputs on a dedicated thread, software frames are played by the automated player instead
+    if (!headless) {
+        inputInit();
+    }
+
+    // Main game loop, the software backend renders a fixed number of frames as fast as it can
+    long frame = 0;
+    long homeFrames = 0;
+    Clock renderClock;
+    TelemetryPhases phases;
+    while (headless ? frame < renderConfig.frames : window.isOpen()) {
         // Handle close window events
         Event event;
-        while (window.pollEvent(event)) {
+        while (!headless && window.pollEvent(event)) {
             if (event.type == Event::Closed || (event.type == Event::KeyPressed && event.key.code == Keyboard::Escape)) {
                 window.close();
             }
         }
 
-        // Maintain frame rate
-        Time frameTime = clock.restart();
-        deltaTime = frameTime.asSeconds();
-        Time sleepTime = Time::Zero;
-        if (deltaTime < targetFrameTime) {
-            sleepTime = seconds(targetFrameTime) - frameTime;
-            sleep(sleepTime);
-        }
-
-        window.clear();
+        // Time the parts of the frame for the telemetry stream
+        uint8_t telemetryScreen = (currentScreen == Screen::GAME) ? 1 : 0;
+        phases.begin();
+        beginFrame();
+        phases.end(PHASE_DRAW);
 
         // Draw the appropriate screen
         switch (currentScreen) {
             case Screen::HOME:
-                // Background game simulation
-                if (mushrooms.size() == 0) {
-                    generateMushrooms();
-                }
-                if (!centipede.getRandomWalk()) centipede.setRandomWalk(true);
-                centipede.move();
+                stepHome();
+                phases.end(PHASE_SIMULATE);
 
                 resetAllTextureColors();
-                window.draw(backgroundSprite);
+                drawFieldLayer();
                 centipede.draw();
-                drawMushrooms();
-                window.draw(titleText);
-                window.draw(messageText);
+                drawText(titleText);
+                drawText(messageText);
                 highScoreText.setOrigin(0.5f * highScoreBounds.width, 0.5f * highScoreBounds.height);
                 highScoreText.setPosition(0.5f * windowWidth, 0.5f * windowHeight);
-                window.draw(highScoreText);
-                if (Keyboard::isKeyPressed(Keyboard::Return)) {
+                drawText(highScoreText);
+                phases.end(PHASE_DRAW);
+                if (headless ? ++homeFrames > renderConfig.attractFrames : (latchInputs() & KEY_START) != 0) {
                     // Start the game
                     currentScreen = Screen::GAME;
+                    homeFrames = 0;
                     highScoreText.setOrigin(0, 0.5f * highScoreBounds.height);
                     highScoreText.setPosition(10, 10);
-                    generateMushrooms();
-                    centipede.setRandomWalk(false);
-                    centipede.reset();
-                    player.reset();
-                    spider.reset();
+                    startGame();
+                    prefetchTextureVariant((getTextureVariant() + 1) % textureVariantCount);
                 }
+                phases.end(PHASE_SIMULATE);
                 break;
-            case Screen::GAME:
-                // Update text elements
-                window.draw(backgroundSprite);
-                str << "Score: " << formatWithCommas(player.getScore());
-                scoreText.setString(str.str());
-                str.str("");
+            case Screen::GAME: {
+                // Snapshot the state that makes a frame non-steady and the heap allocation count
+                long allocationsBefore = getHeapAllocationCount();
+                int scoreBefore = player.getScore();
+                int livesBefore = player.getLives();
+
+                // Snapshot the values shown by the HUD
                 player.updateHighScore();
-                str << "High Score: " << formatWithCommas(player.getHighScore());
-                highScoreText.setString(str.str());
-                str.str("");
-                updateLifeSprites(livesSprites, totalLivesWidth);
-
-                // Check if player wants to shoot
-                if (Keyboard::isKeyPressed(Keyboard::Space)) {
-                    player.shoot();
-                }
+                hudScore = player.getScore();
+                hudHighScore = player.getHighScore();
+                hudLives = player.getLives();
+
+                // Latch the sampled inputs as late as possible before acting on them
+                frameKeys = headless ? autoPlayerKeys() : latchInputs();
 
-                // Update all game elements
-                player.update(getInputs());
-                centipede.move();
-                spider.update();
+                // Update the HUD and all game elements
+                frameGraph.run();
+                GameTickResult result = frameResult;
+
+                // Rotate the texture colors for the new centipede
+                if (result.waveCleared) {
+                    rotateAllTextureColors();
+                }
+                phases.end(PHASE_SIMULATE);
 
                 // Draw all game elements
-                drawMushrooms();
+                drawFieldLayer();
                 centipede.draw();
                 spider.draw();
                 player.draw();
-                window.draw(scoreText);
-                window.draw(highScoreText);
-                window.draw(livesLabelText);
+                drawText(scoreText);
+                drawText(highScoreText);
+                drawText(livesLabelText);
                 drawLives(livesSprites);
+                phases.end(PHASE_DRAW);
 
-                // Check if the centipede is dead
-                bool centipedeAlive = false;
-                for (ECE_CentipedeSegment& segment : centipede.getSegments()) {
-                    if (segment.getStatus() == CharacterStatus::ALIVE) {
-                        centipedeAlive = true;
-                        break;
-                    }
-                }
-                // Spawn a new centipede if the current one is dead and rotate the texture colors
-                if (!centipedeAlive) {
-                    centipede.reset(false);
-                    centipede.setSpeed(centipede.getSpeed() + 1);
-                    spider.setSpeed(spider.getSpeed() + 1);
-                    rotateAllTextureColors();
-                }
+                // Steady-state frames should draw all their temporaries from the frame arena
+                bool steadyFrame = player.getScore() == scoreBefore && player.getLives() == livesBefore && !result.waveCleared;
+                checkFrameAllocations(allocationsBefore, steadyFrame);
 
-                // Check if the player is dead
-                if (player.getLives() == 0) {
-                    centipede.reset(true);
-                    mushrooms.clear();
-                    player.updateHighScore();
-                    str << "High Score: " << formatWithCommas(player.getHighScore());
-                    highScoreText.setString(str.str());
-                    str.str("");
+                // Return to the home screen once the player is dead
+                if (result.gameOver) {
+                    displayedHighScore = player.getHighScore();
+                    setNumberText(highScoreText, "High Score: ", displayedHighScore);
                     currentScreen = Screen::HOME;
                 }
                 break;
+            }
         }
 
-        window.display();
+        if (!headless) {
+            window.display();
+        } else if (frame + 1 == renderConfig.frames && !renderConfig.outputPath.empty()) {
+            if (framebuffer.saveToFile(renderConfig.outputPath)) {
+                printf("Frame %ld written to %s\n", frame, renderConfig.outputPath.c_str());
+            } else {
+                printf("Failed to write frame to %s\n", renderConfig.outputPath.c_str());
+            }
+        }
+        phases.end(PHASE_PRESENT);
+        recordTelemetryTick(telemetryScreen, phases);
+        frame++;
+
+        // Release all of this frame's temporaries at once and move animations on to the next frame
+        frameArenaReset();
+        animationAdvance();
+        memoryFrameEnd();
+
+        // Maintain frame rate
+        if (!headless) {
+            framePacer.wait();
+        }
+    }
+
+    if (headless) {
+        double seconds = renderClock.getElapsedTime().asSeconds();
+        printf("Software rendered %ld frames at %dx%d in %.2f s (%.1f frames per second)\n", frame, windowWidth, windowHeight, seconds, frame / seconds);
+    }
+    inputShutdown();
+    telemetryShutdown();
+    framePacer.report();
+    reportFieldLayerStats();
+    reportTextureVariants();
+    reportCollisionEvents();
+    reportFlowField();
+    reportFrameAllocations();
+    reportMemoryUsage();
+    saveConfiguredLevel();
+    if (taskGraphPath) {
+        FILE* file = fopen(taskGraphPath, "w");
+        if (!file) {
+            printf("Failed to write task graph to %s\n", taskGraphPath);
+        } else {
+            frameGraph.writeDot(file);
+            fclose(file);
+            printf("Task graph written to %s\n", taskGraphPath);
+        }
     }
 
     return 0;
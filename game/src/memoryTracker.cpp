@@ -0,0 +1,181 @@
+#include "memoryTracker.h"
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <cstddef>
+#include <cstdio>
+#include <cstdlib>
+#include <new>
+
+static std::atomic<long> heapAllocations{0}; ///< The number of calls to the global operator new.
+
+long getHeapAllocationCount() {
+    return heapAllocations.load(std::memory_order_relaxed);
+}
+
+#ifndef CENTIPEDE_MEMORY_TRACKING
+
+void* operator new(std::size_t size) {
+    heapAllocations.fetch_add(1, std::memory_order_relaxed);
+    if (void* ptr = std::malloc(size ? size : 1)) {
+        return ptr;
+    }
+    throw std::bad_alloc();
+}
+
+void operator delete(void* ptr) noexcept {
+    std::free(ptr);
+}
+
+void operator delete(void* ptr, std::size_t) noexcept {
+    std::free(ptr);
+}
+
+void memoryFrameEnd() {
+}
+
+void reportMemoryUsage() {
+    printf("Memory tracking disabled, %ld heap allocations\n", getHeapAllocationCount());
+}
+
+#else
+
+static const size_t subsystemCount = static_cast<size_t>(Subsystem::COUNT);
+static const char* subsystemNames[subsystemCount] = {"other", "centipede", "mushroom", "laser", "spider", "hud", "textures"};
+
+/**
+ * @struct AllocationHeader
+ * @brief Prefixed to every allocation so its size and subsystem are known when freed.
+ */
+struct alignas(std::max_align_t) AllocationHeader {
+    std::size_t size; ///< The size requested by the caller.
+    Subsystem subsystem; ///< The subsystem the allocation was attributed to.
+};
+
+/**
+ * @struct SubsystemCounters
+ * @brief Live counters for one subsystem, updated from any thread.
+ */
+struct SubsystemCounters {
+    std::atomic<long> allocations{0}; ///< Allocations made since startup.
+    std::atomic<long> bytes{0}; ///< Bytes allocated since startup.
+    std::atomic<long> liveBytes{0}; ///< Bytes currently allocated.
+    std::atomic<long> highWater{0}; ///< The most bytes ever allocated at once.
+    std::atomic<long> frameAllocations{0}; ///< Allocations made in the current frame.
+    std::atomic<long> frameBytes{0}; ///< Bytes allocated in the current frame.
+};
+
+/**
+ * @struct SubsystemFrameStats
+ * @brief Per-frame statistics for one subsystem, only touched by the main thread.
+ */
+struct SubsystemFrameStats {
+    long maxFrameAllocations = 0; ///< The most allocations made in a single frame.
+    long maxFrameBytes = 0; ///< The most bytes allocated in a single frame.
+    long allocatingFrames = 0; ///< The number of frames with at least one allocation.
+    std::array<long, 10> samples = {}; ///< Live bytes at the most recent growth samples.
+    bool flagged = false; ///< Whether unbounded growth has already been reported.
+};
+
+static std::array<SubsystemCounters, subsystemCount> counters; ///< Live counters per subsystem.
+static std::array<SubsystemFrameStats, subsystemCount> frameStats; ///< Per-frame statistics per subsystem.
+static thread_local Subsystem currentSubsystem = Subsystem::OTHER; ///< The subsystem this thread allocates for.
+static long frames = 0; ///< The number of frames closed.
+static long samplesTaken = 0; ///< The number of growth samples taken.
+
+static const long framesPerSample = 3600; ///< Frames between growth samples, a minute at 60 FPS.
+static const long minimumGrowth = 64 * 1024; ///< Growth across the sample window needed to flag a subsystem.
+
+MemoryScope::MemoryScope(Subsystem subsystem) {
+    previous = currentSubsystem;
+    currentSubsystem = subsystem;
+}
+
+MemoryScope::~MemoryScope() {
+    currentSubsystem = previous;
+}
+
+void* operator new(std::size_t size) {
+    heapAllocations.fetch_add(1, std::memory_order_relaxed);
+    auto* header = static_cast<AllocationHeader*>(std::malloc(sizeof(AllocationHeader) + size));
+    if (!header) {
+        throw std::bad_alloc();
+    }
+    header->size = size;
+    header->subsystem = currentSubsystem;
+
+    SubsystemCounters& counter = counters[static_cast<size_t>(header->subsystem)];
+    counter.allocations.fetch_add(1, std::memory_order_relaxed);
+    counter.bytes.fetch_add(size, std::memory_order_relaxed);
+    counter.frameAllocations.fetch_add(1, std::memory_order_relaxed);
+    counter.frameBytes.fetch_add(size, std::memory_order_relaxed);
+    long live = counter.liveBytes.fetch_add(size, std::memory_order_relaxed) + size;
+    long highWater = counter.highWater.load(std::memory_order_relaxed);
+    while (live > highWater && !counter.highWater.compare_exchange_weak(highWater, live, std::memory_order_relaxed)) {
+    }
+    return header + 1;
+}
+
+void operator delete(void* ptr) noexcept {
+    if (!ptr) {
+        return;
+    }
+    auto* header = static_cast<AllocationHeader*>(ptr) - 1;
+    counters[static_cast<size_t>(header->subsystem)].liveBytes.fetch_sub(header->size, std::memory_order_relaxed);
+    std::free(header);
+}
+
+void operator delete(void* ptr, std::size_t) noexcept {
+    operator delete(ptr);
+}
+
+void memoryFrameEnd() {
+    frames++;
+    bool sample = frames % framesPerSample == 0;
+    if (sample) {
+        samplesTaken++;
+    }
+
+    for (size_t i = 0; i < subsystemCount; ++i) {
+        SubsystemFrameStats& stats = frameStats[i];
+        long frameAllocations = counters[i].frameAllocations.exchange(0, std::memory_order_relaxed);
+        long frameBytes = counters[i].frameBytes.exchange(0, std::memory_order_relaxed);
+        stats.maxFrameAllocations = std::max(stats.maxFrameAllocations, frameAllocations);
+        stats.maxFrameBytes = std::max(stats.maxFrameBytes, frameBytes);
+        if (frameAllocations > 0) {
+            stats.allocatingFrames++;
+        }
+
+        if (!sample) {
+            continue;
+        }
+
+        // Shift in the newest live byte sample and flag the subsystem if it rose at every sample
+        std::copy(stats.samples.begin() + 1, stats.samples.end(), stats.samples.begin());
+        stats.samples.back() = counters[i].liveBytes.load(std::memory_order_relaxed);
+        if (stats.flagged || samplesTaken < static_cast<long>(stats.samples.size())) {
+            continue;
+        }
+        bool rising = true;
+        for (size_t s = 1; s < stats.samples.size(); ++s) {
+            rising = rising && stats.samples[s] > stats.samples[s - 1];
+        }
+        if (rising && stats.samples.back() - stats.samples.front() >= minimumGrowth) {
+            stats.flagged = true;
+            printf("Memory warning: %s live bytes grew from %ld to %ld over the last %zu samples\n", subsystemNames[i], stats.samples.front(), stats.samples.back(), stats.samples.size());
+        }
+    }
+}
+
+void reportMemoryUsage() {
+    printf("Memory usage over %ld frames:\n", frames);
+    printf("  %-10s %10s %12s %10s %12s %12s %14s %12s\n", "subsystem", "allocs", "bytes", "live", "high-water", "peak allocs", "peak bytes", "frames");
+    for (size_t i = 0; i < subsystemCount; ++i) {
+        const SubsystemFrameStats& stats = frameStats[i];
+        printf("  %-10s %10ld %12ld %10ld %12ld %12ld %14ld %12ld%s\n", subsystemNames[i],
+            counters[i].allocations.load(), counters[i].bytes.load(), counters[i].liveBytes.load(), counters[i].highWater.load(),
+            stats.maxFrameAllocations, stats.maxFrameBytes, stats.allocatingFrames, stats.flagged ? "  (unbounded growth)" : "");
+    }
+}
+
+#endif
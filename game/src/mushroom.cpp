@@ -1,76 +1,280 @@
 #include "mushroom.h"
+#include <algorithm>
+#include <atomic>
+#include <cstdlib>
+#include <cstring>
+#include <mutex>
 #include <random>
-#include <list>
+#include <unordered_set>
 #include "globals.h"
+#include "fieldLayer.h"
+#include "fieldStream.h"
+#include "frameArena.h"
+#include "levelFile.h"
+#include "memoryTracker.h"
+#include "parallel.h"
+#include "renderBackend.h"
 
 Texture normalMushroomTexture, damagedMushroomTexture;
-std::list<Mushroom> mushrooms;
+EntityStore mushrooms;
+
+static BoxArray mushroomBoxes; ///< The bounds of the living mushrooms.
+static std::atomic<bool> mushroomBoxesStale{true}; ///< Whether a mushroom changed since the boxes were built.
+static std::mutex mushroomBoxesMutex; ///< Serializes rebuilds by concurrent readers.
+static uint32_t mushroomBoxesVersion = 0; ///< Incremented by every rebuild of the boxes.
+static bool mushroomSeeded = false; ///< Whether fields are generated from nextMushroomSeed.
+static uint32_t nextMushroomSeed = 0; ///< The seed of the next generated field.
+static MushroomLayout mushroomLayout = MushroomLayout::UNIFORM; ///< How generated fields are spread.
 
 void mushroomInit() {
+    MemoryScope scope(Subsystem::TEXTURES);
+
     // Load textures
-    if (!normalMushroomTexture.loadFromFile("assets/textures/Mushroom0.png")) {
+    if (!loadTexture(normalMushroomTexture, "assets/textures/Mushroom0.png")) {
         printf("Failed to load texture from %s\n", "assets/textures/Mushroom0.png");
     }
-    if (!damagedMushroomTexture.loadFromFile("assets/textures/Mushroom1.png")) {
+    if (!loadTexture(damagedMushroomTexture, "assets/textures/Mushroom1.png")) {
         printf("Failed to load texture from %s\n", "assets/textures/Mushroom1.png");
     }
 }
 
-Mushroom::Mushroom() {
-    health = 2;
-    setTexture(normalMushroomTexture);
-    id = globalCounter++;
+FixedRect getMushroomBounds(Entity mushroom) {
+    return mushrooms.colliders.get(mushroom)->bounds(*mushrooms.placements.get(mushroom));
 }
 
-void Mushroom::handleCollision() {
+void hitMushroom(Entity mushroom) {
+    int& health = mushrooms.healths.get(mushroom)->hitPoints;
     health--;
+    patchFieldLayer(getMushroomBounds(mushroom).toFloat());
     if (health == 1) {
-        setTexture(damagedMushroomTexture);
+        mushrooms.renderables.get(mushroom)->texture = &damagedMushroomTexture;
     } else if (health == 0) {
-        mushrooms.remove(*this);
+        mushroomBoxesStale = true;
+        mushrooms.destroy(mushroom);
+    }
+}
+
+void eatMushroom(Entity mushroom) {
+    mushrooms.healths.get(mushroom)->hitPoints = 0;
+    patchFieldLayer(getMushroomBounds(mushroom).toFloat());
+    mushroomBoxesStale = true;
+}
+
+void sampleDistinctCells(uint32_t range, uint32_t count, std::mt19937& gen, std::pmr::vector<uint32_t>& picked) {
+    std::pmr::unordered_set<uint32_t> seen(frameArena());
+    seen.reserve(count);
+    for (uint32_t j = range - count; j < range; ++j) {
+        // Values below j were all available earlier, so j itself stands in for a repeat
+        uint32_t value = std::uniform_int_distribution<uint32_t>(0, j)(gen);
+        if (!seen.insert(value).second) {
+            value = j;
+            seen.insert(j);
+        }
+        picked.push_back(value);
+    }
+}
+
+/**
+ * @brief Mixes a seed and a stream number into the seed of an independent generator.
+ *
+ * @param seed The field seed.
+ * @param stream The stream number, such as a tile index.
+ * @return uint32_t The mixed seed.
+ */
+static uint32_t mixSeed(uint32_t seed, uint32_t stream) {
+    uint64_t z = ((static_cast<uint64_t>(seed) << 32) | stream) + 0x9E3779B97F4A7C15ULL;
+    z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ULL;
+    z = (z ^ (z >> 27)) * 0x94D049BB133111EBULL;
+    return static_cast<uint32_t>(z ^ (z >> 31));
+}
+
+/**
+ * @brief Builds a Poisson-disk set of grid cells by dart throwing, tile by tile.
+ *
+ * The field is cut into tiles at least spacing cells wide and the tiles are
+ * visited in four checkerboard passes. Tiles of one pass are a whole tile
+ * apart, so they run in parallel without ever testing a cell another of them
+ * writes, and each tile draws from its own generator.
+ *
+ * @param columns The number of grid columns.
+ * @param rows The number of grid rows.
+ * @param spacing The smallest distance in cells between two accepted cells, counting diagonals as one.
+ * @param seed The field seed.
+ * @param cells Receives the accepted cells as column * rows + row, in tile order.
+ */
+static void blueNoiseCells(int columns, int rows, int spacing, uint32_t seed, std::vector<uint32_t>& cells) {
+    int tileSize = std::max(spacing, 8);
+    int tileColumns = (columns + tileSize - 1) / tileSize;
+    int tileRows = (rows + tileSize - 1) / tileSize;
+    std::vector<uint8_t> occupied(static_cast<size_t>(columns) * rows, 0);
+    std::vector<std::vector<uint32_t>> accepted(static_cast<size_t>(tileColumns) * tileRows);
+
+    for (int pass = 0; pass < 4; ++pass) {
+        int passColumns = (tileColumns - pass % 2 + 1) / 2;
+        int passRows = (tileRows - pass / 2 + 1) / 2;
+        parallelFor(static_cast<size_t>(passColumns) * passRows, [&](size_t i) {
+            int tileColumn = static_cast<int>(i % passColumns) * 2 + pass % 2;
+            int tileRow = static_cast<int>(i / passColumns) * 2 + pass / 2;
+            size_t tile = static_cast<size_t>(tileRow) * tileColumns + tileColumn;
+            int left = tileColumn * tileSize;
+            int top = tileRow * tileSize;
+            int width = std::min(tileSize, columns - left);
+            int height = std::min(tileSize, rows - top);
+            std::minstd_rand gen(mixSeed(seed, static_cast<uint32_t>(tile)));
+
+            // Throw one dart per cell of the tile, keeping the ones with no accepted cell too close
+            for (int dart = 0; dart < width * height; ++dart) {
+                int column = left + static_cast<int>(gen() % width);
+                int row = top + static_cast<int>(gen() % height);
+                bool clear = true;
+                for (int c = std::max(0, column - spacing + 1); clear && c < std::min(columns, column + spacing); ++c) {
+                    for (int r = std::max(0, row - spacing + 1); r < std::min(rows, row + spacing); ++r) {
+                        if (occupied[static_cast<size_t>(c) * rows + r]) {
+                            clear = false;
+                            break;
+                        }
+                    }
+                }
+                if (clear) {
+                    uint32_t cell = static_cast<uint32_t>(column) * rows + row;
+                    occupied[cell] = 1;
+                    accepted[tile].push_back(cell);
+                }
+            }
+        });
+    }
+
+    cells.clear();
+    for (const std::vector<uint32_t>& tileCells : accepted) {
+        cells.insert(cells.end(), tileCells.begin(), tileCells.end());
     }
 }
 
 void generateMushrooms() {
-    mushrooms.clear();
-    int spriteWidth = normalMushroomTexture.getSize().x;
-    int spriteHeight = normalMushroomTexture.getSize().y;
-    std::random_device rd;
-    std::mt19937 gen(rd());
-
-    // Generate a list of possible positions allowing for a 1 sprite top, left, and right border and 3 sprite bottom border
-    std::vector<std::pair<int, int>> possiblePositions;
-    for (int x = spriteWidth; x < (windowWidth / spriteWidth) * spriteWidth - spriteWidth; x += spriteWidth) {
-        for (int y = spriteHeight; y < (windowHeight / spriteHeight) * spriteHeight - spriteHeight * 3; y += spriteHeight) {
-            possiblePositions.emplace_back(x, y);
+    if (applyConfiguredLevel()) {
+        return;
+    }
+    uint32_t seed = mushroomSeeded ? nextMushroomSeed++ : std::random_device()();
+    if (isEndless()) {
+        resetFieldStream(seed);
+        return;
+    }
+    generateMushrooms(seed, mushroomsPerField, mushroomLayout);
+}
+
+void generateMushrooms(uint32_t seed, int count, MushroomLayout layout, int spacing) {
+    MemoryScope scope(Subsystem::MUSHROOM);
+    clearMushrooms();
+    int spriteWidth = getTextureSize(normalMushroomTexture).x;
+    int spriteHeight = getTextureSize(normalMushroomTexture).y;
+    std::mt19937 gen(seed);
+
+    // Mushrooms sit on grid cells allowing for a 1 sprite top, left, and right border and 3 sprite bottom border
+    int columns = std::max(0, windowWidth / spriteWidth - 2);
+    int rows = std::max(0, windowHeight / spriteHeight - 4);
+
+    // Pick the cells without ever listing the whole field
+    std::pmr::vector<uint32_t> picked(frameArena());
+    if (layout == MushroomLayout::BLUE_NOISE) {
+        std::vector<uint32_t> candidates;
+        blueNoiseCells(columns, rows, std::max(spacing, 1), seed, candidates);
+        uint32_t available = static_cast<uint32_t>(candidates.size());
+        sampleDistinctCells(available, std::min(available, static_cast<uint32_t>(std::max(count, 0))), gen, picked);
+        for (uint32_t& cell : picked) {
+            cell = candidates[cell];
         }
+    } else {
+        uint32_t available = static_cast<uint32_t>(columns) * rows;
+        sampleDistinctCells(available, std::min(available, static_cast<uint32_t>(std::max(count, 0))), gen, picked);
     }
-    // Shuffle the possible positions
-    std::shuffle(possiblePositions.begin(), possiblePositions.end(), gen);
-
-    // Place 30 mushrooms
-    int count = 0;
-    for (auto& pos : possiblePositions) {
-        if (count >= 30) break;
-        int x = pos.first;
-        int y = pos.second;
-        Mushroom mushroom;
-        mushroom.setPosition(x, y);
-        mushrooms.push_back(mushroom);
-        count++;
+
+    for (uint32_t cell : picked) {
+        addMushroom((cell / rows + 1) * spriteWidth, (cell % rows + 1) * spriteHeight);
     }
 }
 
-void addMushroom(int x, int y) {
-    Mushroom mushroom;
-    mushroom.setPosition(x, y);
-    mushrooms.push_back(mushroom);
+void parseMushroomArgs(int argc, char* argv[]) {
+    bool fieldSeedGiven = false;
+    for (int i = 1; i + 1 < argc; ++i) {
+        if (strcmp(argv[i], "--mushroom-seed") == 0 || (strcmp(argv[i], "--seed") == 0 && !fieldSeedGiven)) {
+            fieldSeedGiven = fieldSeedGiven || strcmp(argv[i], "--mushroom-seed") == 0;
+            mushroomSeeded = true;
+            nextMushroomSeed = static_cast<uint32_t>(strtoul(argv[++i], nullptr, 10));
+        } else if (strcmp(argv[i], "--mushroom-layout") == 0) {
+            const char* name = argv[++i];
+            if (strcmp(name, "blue-noise") == 0) {
+                mushroomLayout = MushroomLayout::BLUE_NOISE;
+            } else if (strcmp(name, "uniform") == 0) {
+                mushroomLayout = MushroomLayout::UNIFORM;
+            } else {
+                printf("Unknown mushroom layout %s, using uniform\n", name);
+            }
+        }
+    }
 }
 
-void drawMushrooms() {
-    for (auto& mushroom : mushrooms) {
-        if (mushroom.getHealth() > 0) {
-            window.draw(mushroom);
+Entity addMushroom(int x, int y, int health) {
+    MemoryScope scope(Subsystem::MUSHROOM);
+    Entity mushroom = mushrooms.create();
+    Placement placement = {{toFixed(x), toFixed(y)}};
+    Collider collider = {toFixed(getTextureSize(normalMushroomTexture).x), toFixed(getTextureSize(normalMushroomTexture).y)};
+    mushrooms.placements.insert(mushroom, placement);
+    mushrooms.colliders.insert(mushroom, collider);
+    mushrooms.healths.insert(mushroom, {health});
+    mushrooms.renderables.insert(mushroom, {(health < 2) ? &damagedMushroomTexture : &normalMushroomTexture});
+    patchFieldLayer(collider.bounds(placement).toFloat());
+    mushroomBoxesStale = true;
+    return mushroom;
+}
+
+void removeMushroom(Entity mushroom) {
+    patchFieldLayer(getMushroomBounds(mushroom).toFloat());
+    mushroomBoxesStale = true;
+    mushrooms.destroy(mushroom);
+}
+
+void scrollMushrooms(Fixed dy, Fixed bottom) {
+    for (size_t i = 0; i < mushrooms.placements.size();) {
+        FixedVec& position = mushrooms.placements[i].position;
+        position.y += dy;
+        if (position.y >= bottom) {
+            // Destroying moves the last placement into this one, which is visited next
+            mushrooms.destroy(mushrooms.placements.entityAt(i));
+        } else {
+            ++i;
         }
     }
-}
\ No newline at end of file
+
+    // Every mushroom moved, so the whole layer is stale
+    invalidateFieldLayer();
+    mushroomBoxesStale = true;
+}
+
+void clearMushrooms() {
+    mushrooms.clear();
+    invalidateFieldLayer();
+    mushroomBoxesStale = true;
+}
+
+const BoxArray& getMushroomBoxes() {
+    if (mushroomBoxesStale.load(std::memory_order_acquire)) {
+        std::lock_guard<std::mutex> lock(mushroomBoxesMutex);
+        if (mushroomBoxesStale.load(std::memory_order_relaxed)) {
+            MemoryScope scope(Subsystem::MUSHROOM);
+            mushroomBoxes.clear();
+            for (size_t i = 0; i < mushrooms.healths.size(); ++i) {
+                if (mushrooms.healths[i].hitPoints > 0) {
+                    Entity mushroom = mushrooms.healths.entityAt(i);
+                    mushroomBoxes.push(getMushroomBounds(mushroom), mushroom.index);
+                }
+            }
+            mushroomBoxesVersion++;
+            mushroomBoxesStale.store(false, std::memory_order_release);
+        }
+    }
+    return mushroomBoxes;
+}
+
+uint32_t getMushroomBoxesVersion() {
+    return mushroomBoxesVersion;
+}
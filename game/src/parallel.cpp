@@ -0,0 +1,50 @@
+#include "parallel.h"
+#include <algorithm>
+#include <atomic>
+#include "threadPool.h"
+
+/**
+ * @struct ParallelForJob
+ * @brief The shared state of one parallelFor call.
+ */
+struct ParallelForJob {
+    const std::function<void(size_t)>* body; ///< The function to run for each index.
+    size_t count; ///< The number of indices.
+    std::atomic<size_t> next{0}; ///< The next index to hand out.
+    std::atomic<size_t> pending{0}; ///< The number of pool jobs still running.
+};
+
+/**
+ * @brief Runs indices of a parallelFor until none are left.
+ *
+ * @param context The ParallelForJob.
+ */
+static void runIndices(void* context, size_t) {
+    ParallelForJob& job = *static_cast<ParallelForJob*>(context);
+    for (size_t i = job.next.fetch_add(1); i < job.count; i = job.next.fetch_add(1)) {
+        (*job.body)(i);
+    }
+    job.pending.fetch_sub(1);
+}
+
+void parallelFor(size_t count, const std::function<void(size_t)>& body) {
+    ThreadPool& pool = ThreadPool::instance();
+    if (pool.getWorkerCount() == 0 || count < 2) {
+        for (size_t i = 0; i < count; ++i) {
+            body(i);
+        }
+        return;
+    }
+
+    // Queue one job per helper that could usefully take part, then work alongside them
+    ParallelForJob job;
+    job.body = &body;
+    job.count = count;
+    size_t helpers = std::min(count - 1, pool.getWorkerCount());
+    job.pending = helpers + 1;
+    for (size_t i = 0; i < helpers; ++i) {
+        pool.submit({runIndices, &job, i});
+    }
+    runIndices(&job, 0);
+    pool.helpUntilDone(job.pending);
+}
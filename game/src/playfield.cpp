@@ -0,0 +1,11 @@
+#include "playfield.h"
+
+static bool genericPlayfield = false; ///< Whether withPlayfield() always takes the runtime fallback.
+
+void setGenericPlayfield(bool generic) {
+    genericPlayfield = generic;
+}
+
+bool isGenericPlayfield() {
+    return genericPlayfield;
+}
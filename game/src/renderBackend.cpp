@@ -0,0 +1,131 @@
+#include "renderBackend.h"
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include "globals.h"
+
+Framebuffer framebuffer;
+
+static RenderConfig renderConfig; ///< The settings parsed from the command line.
+
+void parseRenderArgs(int argc, char* argv[]) {
+    for (int i = 1; i + 1 < argc; ++i) {
+        if (strcmp(argv[i], "--render-backend") == 0) {
+            const char* name = argv[++i];
+            if (strcmp(name, "software") == 0) {
+                renderConfig.backend = RenderBackend::SOFTWARE;
+            } else if (strcmp(name, "window") == 0) {
+                renderConfig.backend = RenderBackend::WINDOW;
+            } else {
+                printf("Unknown render backend %s, using window\n", name);
+            }
+        } else if (strcmp(argv[i], "--render-frames") == 0) {
+            renderConfig.frames = atol(argv[++i]);
+        } else if (strcmp(argv[i], "--render-output") == 0) {
+            renderConfig.outputPath = argv[++i];
+        }
+    }
+}
+
+const RenderConfig& getRenderConfig() {
+    return renderConfig;
+}
+
+void setRenderBackend(RenderBackend backend) {
+    renderConfig.backend = backend;
+}
+
+bool isSoftwareRendering() {
+    return renderConfig.backend == RenderBackend::SOFTWARE;
+}
+
+void drawSprite(const Sprite& sprite) {
+    if (isSoftwareRendering()) {
+        framebuffer.draw(sprite);
+    } else {
+        window.draw(sprite);
+    }
+}
+
+void drawBatch(const SpriteBatch& batch) {
+    if (isSoftwareRendering()) {
+        batch.draw(framebuffer);
+    } else {
+        batch.draw(window);
+    }
+}
+
+void drawText(const Text& text) {
+    if (isSoftwareRendering()) {
+        framebuffer.draw(text);
+    } else {
+        window.draw(text);
+    }
+}
+
+void beginFrame() {
+    if (isSoftwareRendering()) {
+        framebuffer.clear();
+    } else {
+        window.clear();
+    }
+}
+
+bool loadTexture(Texture& texture, const std::string& path) {
+    if (!isSoftwareRendering()) {
+        return texture.loadFromFile(path);
+    }
+    Image image;
+    if (!image.loadFromFile(path)) {
+        return false;
+    }
+    setTextureImage(texture, image);
+    return true;
+}
+
+bool loadTexture(Texture& texture, const Image& image) {
+    if (!isSoftwareRendering()) {
+        return texture.loadFromImage(image);
+    }
+    setTextureImage(texture, image);
+    return true;
+}
+
+void updateTexture(Texture& texture, const Uint8* pixels) {
+    if (findTextureImage(texture)) {
+        updateTextureImage(texture, pixels);
+    } else {
+        texture.update(pixels);
+    }
+}
+
+Image copyTextureImage(const Texture& texture) {
+    const Image* image = findTextureImage(texture);
+    return image ? *image : texture.copyToImage();
+}
+
+Vector2u getTextureSize(const Texture& texture) {
+    const Image* image = findTextureImage(texture);
+    return image ? image->getSize() : texture.getSize();
+}
+
+void setSpriteTexture(Sprite& sprite, const Texture& texture) {
+    Vector2u size = getTextureSize(texture);
+    sprite.setTexture(texture);
+    sprite.setTextureRect(IntRect(0, 0, static_cast<int>(size.x), static_cast<int>(size.y)));
+}
+
+bool loadFont(Font& font, const std::string& path) {
+    // Loading a font only parses the file, its glyph pages are created on first use
+    if (!font.loadFromFile(path)) {
+        return false;
+    }
+    if (isSoftwareRendering()) {
+        loadGlyphFont(font, path);
+    }
+    return true;
+}
+
+FloatRect getTextBounds(const Text& text) {
+    return isSoftwareRendering() ? measureText(text) : text.getLocalBounds();
+}
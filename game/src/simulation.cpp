@@ -0,0 +1,160 @@
+#include "simulation.h"
+#include <cstdlib>
+#include <cstring>
+#include "centipede.h"
+#include "collisionEvents.h"
+#include "fieldStream.h"
+#include "input.h"
+#include "laserBlaster.h"
+#include "mushroom.h"
+#include "spider.h"
+#include "timerWheel.h"
+
+static int wave = 1; ///< The wave being played, counting from 1 each game.
+static bool simulationSeeded = false; ///< Whether games are seeded from nextSimulationSeed.
+static uint32_t nextSimulationSeed = 0; ///< The seed of the next game.
+
+Direction getInputs(uint8_t keys) {
+    if (keys & KEY_LEFT) {
+        return Direction::LEFT;
+    }
+    else if (keys & KEY_RIGHT) {
+        return Direction::RIGHT;
+    }
+    else if (keys & KEY_UP) {
+        return Direction::UP;
+    }
+    else if (keys & KEY_DOWN) {
+        return Direction::DOWN;
+    }
+    return Direction::NONE;
+}
+
+void parseSimulationArgs(int argc, char* argv[]) {
+    const char* seed = nullptr;
+    for (int i = 1; i + 1 < argc; ++i) {
+        if (strcmp(argv[i], "--seed") == 0 || (strcmp(argv[i], "--mushroom-seed") == 0 && !seed)) {
+            seed = argv[i + 1];
+        }
+    }
+    if (seed) {
+        simulationSeeded = true;
+        nextSimulationSeed = static_cast<uint32_t>(strtoul(seed, nullptr, 10));
+        getSimulationRandom().seed(nextSimulationSeed);
+    }
+}
+
+std::mt19937& getSimulationRandom() {
+    // Function-local so global constructors in other files, such as the spider's, can draw from it
+    static std::mt19937 simulationRandom;
+    return simulationRandom;
+}
+
+void initGameElements() {
+    int centipedeLength = 12;
+    int initialCentipedeSpeed = 2;
+    centipedeInit(centipedeLength, initialCentipedeSpeed);
+    mushroomInit();
+    laserBlasterInit();
+    int initialSpiderSpeed = 2;
+    spiderInit(initialSpiderSpeed);
+}
+
+void stepHome() {
+    // Background game simulation
+    if (mushrooms.size() == 0) {
+        generateMushrooms();
+    }
+    if (!centipede.getRandomWalk()) centipede.setRandomWalk(true);
+    centipede.move();
+}
+
+void startGame() {
+    wave = 1;
+    getSimulationRandom().seed(simulationSeeded ? nextSimulationSeed++ : std::random_device()());
+    generateMushrooms();
+    centipede.setRandomWalk(false);
+    centipede.reset();
+    player.reset();
+    spider.reset();
+}
+
+void addGameTasks(TaskGraph& graph, const uint8_t& keys, GameTickResult& result) {
+    graph.addTask("timers", 0, RES_TIMERS | RES_PLAYER | RES_SPIDER, [] {
+        // Fire the spawn delays and reload cooldowns that run out this tick
+        gameTimers.advance();
+    });
+    graph.addTask("player", RES_MUSHROOMS, RES_PLAYER | RES_BLASTS | RES_TIMERS, [&keys] {
+        // Check if player wants to shoot
+        if (keys & KEY_FIRE) {
+            player.shoot();
+        }
+        player.update(getInputs(keys));
+    });
+    graph.addTask("move blasts", 0, RES_BLASTS, [] {
+        player.moveBlasts();
+    });
+    graph.addTask("centipede", RES_PLAYER | RES_MUSHROOMS, RES_CENTIPEDE, [] {
+        centipede.move();
+    });
+    graph.addTask("spider", 0, RES_SPIDER, [] {
+        spider.update();
+    });
+    if (isEndless()) {
+        graph.addTask("scroll", RES_PLAYER, RES_MUSHROOMS | RES_FIELD_LAYER | RES_CENTIPEDE | RES_FRAME_ARENA, [] {
+            scrollFieldStream();
+        });
+    }
+
+    // Collisions are found against the moved world by passes that only emit events, then applied together
+    graph.addTask("detect player hits", RES_PLAYER | RES_CENTIPEDE | RES_SPIDER, RES_PLAYER_HITS, [] {
+        detectPlayerHits();
+    });
+    graph.addTask("detect blast hits", RES_BLASTS | RES_MUSHROOMS | RES_CENTIPEDE | RES_SPIDER, RES_BLAST_HITS, [] {
+        detectBlastHits();
+    });
+    graph.addTask("detect spider meals", RES_SPIDER | RES_MUSHROOMS, RES_SPIDER_MEALS, [] {
+        detectSpiderMeals();
+    });
+    graph.addTask("resolve collisions", 0, RES_PLAYER_HITS | RES_BLAST_HITS | RES_SPIDER_MEALS | RES_PLAYER | RES_LIVES | RES_SCORE
+        | RES_BLASTS | RES_CENTIPEDE | RES_MUSHROOMS | RES_SPIDER | RES_FIELD_LAYER | RES_TIMERS, [] {
+        resolveCollisions();
+    });
+    graph.addTask("wave", RES_LIVES, RES_CENTIPEDE | RES_SPIDER | RES_MUSHROOMS | RES_FIELD_LAYER | RES_SCORE, [&result] {
+        result = {false, false};
+
+        // Spawn a new centipede if the current one is dead
+        if (!centipede.isAlive()) {
+            centipede.reset(false);
+            centipede.setSpeed(centipede.getSpeed() + 1);
+            spider.setSpeed(spider.getSpeed() + 1);
+            result.waveCleared = true;
+            wave++;
+        }
+
+        // Check if the player is dead
+        if (player.getLives() == 0) {
+            centipede.reset(true);
+            clearMushrooms();
+            player.updateHighScore();
+            result.gameOver = true;
+        }
+    });
+}
+
+int getWave() {
+    return wave;
+}
+
+GameTickResult stepGame(uint8_t keys) {
+    static uint8_t tickKeys = 0;
+    static GameTickResult result = {false, false};
+    static TaskGraph graph;
+    if (graph.size() == 0) {
+        addGameTasks(graph, tickKeys, result);
+    }
+
+    tickKeys = keys;
+    graph.run();
+    return result;
+}
@@ -0,0 +1,191 @@
+#include "soak.h"
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <limits>
+#include "centipede.h"
+#include "fieldStream.h"
+#include "frameArena.h"
+#include "input.h"
+#include "levelFile.h"
+#include "laserBlaster.h"
+#include "memoryTracker.h"
+#include "mushroom.h"
+#include "renderBackend.h"
+#include "simulation.h"
+#include "spider.h"
+#include "telemetry.h"
+#include "timerWheel.h"
+#if defined(__linux__)
+#include <unistd.h>
+#elif defined(__APPLE__)
+#include <mach/mach.h>
+#endif
+
+static const int attractTicks = 10 * gameTicksPerSecond; ///< Ticks spent on the HOME attract loop between games.
+
+/**
+ * @brief Returns the resident set size of the process.
+ *
+ * @return long The resident memory in bytes, or -1 if unsupported on this platform.
+ */
+static long getResidentBytes() {
+#if defined(__linux__)
+    long pages = 0;
+    FILE* statm = fopen("/proc/self/statm", "r");
+    if (!statm) {
+        return -1;
+    }
+    if (fscanf(statm, "%*s %ld", &pages) != 1) {
+        pages = -1;
+    }
+    fclose(statm);
+    return (pages < 0) ? -1 : pages * sysconf(_SC_PAGESIZE);
+#elif defined(__APPLE__)
+    mach_task_basic_info info;
+    mach_msg_type_number_t count = MACH_TASK_BASIC_INFO_COUNT;
+    if (task_info(mach_task_self(), MACH_TASK_BASIC_INFO, reinterpret_cast<task_info_t>(&info), &count) != KERN_SUCCESS) {
+        return -1;
+    }
+    return static_cast<long>(info.resident_size);
+#else
+    return -1;
+#endif
+}
+
+uint8_t autoPlayerKeys() {
+    uint8_t keys = KEY_FIRE;
+    FixedRect playerBounds = player.getFixedBounds();
+    Fixed playerX = playerBounds.left + playerBounds.width / 2;
+
+    // Find the living head closest to the player horizontally
+    Fixed targetX = playerX;
+    Fixed closest = std::numeric_limits<Fixed>::max();
+    for (uint32_t head : centipede.getHeads()) {
+        FixedRect headBounds = centipede.getSegments().getBounds(centipede.getSegments().entityAt(head));
+        Fixed headX = headBounds.left + headBounds.width / 2;
+        if (std::abs(headX - playerX) < closest) {
+            closest = std::abs(headX - playerX);
+            targetX = headX;
+        }
+    }
+
+    if (targetX < playerX - FIXED_ONE) {
+        keys |= KEY_LEFT;
+    } else if (targetX > playerX + FIXED_ONE) {
+        keys |= KEY_RIGHT;
+    }
+    return keys;
+}
+
+bool parseSoakArgs(int argc, char* argv[], SoakConfig& config) {
+    bool soak = false;
+    for (int i = 1; i < argc; ++i) {
+        bool hasValue = i + 1 < argc && argv[i + 1][0] != '-';
+        if (strcmp(argv[i], "--soak") == 0) {
+            soak = true;
+            if (hasValue) config.simulatedSeconds = atof(argv[++i]);
+        } else if (strcmp(argv[i], "--soak-sample") == 0 && hasValue) {
+            config.sampleSeconds = atof(argv[++i]);
+        } else if (strcmp(argv[i], "--soak-max-tps-drop") == 0 && hasValue) {
+            config.maxThroughputDrop = atof(argv[++i]);
+        } else if (strcmp(argv[i], "--soak-max-rss-growth") == 0 && hasValue) {
+            config.maxRssGrowthMb = atof(argv[++i]);
+        }
+    }
+    return soak;
+}
+
+int runSoak(const SoakConfig& config) {
+    using SteadyClock = std::chrono::steady_clock;
+
+    // The soak never draws, so textures are only decoded, never uploaded
+    setRenderBackend(RenderBackend::SOFTWARE);
+    initGameElements();
+
+    long totalTicks = static_cast<long>(config.simulatedSeconds * gameTicksPerSecond);
+    long ticksPerSample = std::max(1L, static_cast<long>(config.sampleSeconds * gameTicksPerSecond));
+    Screen screen = Screen::HOME;
+    long screenTicks = 0;
+    long games = 0;
+    long waves = 0;
+
+    double baselineTps = 0;
+    long baselineRss = -1;
+    SteadyClock::time_point sampleStart = SteadyClock::now();
+    TelemetryPhases phases;
+
+    printf("Soak: %.0f simulated seconds, sampling every %.0f seconds\n", config.simulatedSeconds, config.sampleSeconds);
+
+    for (long tick = 0; tick < totalTicks; ++tick) {
+        uint8_t telemetryScreen = (screen == Screen::GAME) ? 1 : 0;
+        phases.begin();
+        if (screen == Screen::HOME) {
+            // Attract loop, then start a new game
+            stepHome();
+            if (++screenTicks >= attractTicks) {
+                startGame();
+                screen = Screen::GAME;
+                screenTicks = 0;
+                games++;
+            }
+        } else {
+            GameTickResult result = stepGame(autoPlayerKeys());
+            if (result.waveCleared) {
+                waves++;
+            }
+            if (result.gameOver) {
+                screen = Screen::HOME;
+            }
+        }
+        phases.end(PHASE_SIMULATE);
+        recordTelemetryTick(telemetryScreen, phases);
+        frameArenaReset();
+        memoryFrameEnd();
+
+        if ((tick + 1) % ticksPerSample != 0) {
+            continue;
+        }
+
+        // Sample throughput, memory and entity counts
+        SteadyClock::time_point now = SteadyClock::now();
+        double tps = ticksPerSample / std::chrono::duration<double>(now - sampleStart).count();
+        sampleStart = now;
+        long rss = getResidentBytes();
+        int zombieMushrooms = 0;
+        for (const Health& health : mushrooms.healths) {
+            if (health.hitPoints <= 0) zombieMushrooms++;
+        }
+        printf("[soak] t=%8lds tps=%10.0f rss=%8.1fMB segments=%d live/%zu slots mushrooms=%zu (%d zombie)/%zu slots blasts=%zu games=%ld waves=%ld",
+            (tick + 1) / gameTicksPerSecond, tps, rss / (1024.0 * 1024.0), centipede.getLiveCount(), centipede.getSegments().capacity(),
+            mushrooms.size(), zombieMushrooms, mushrooms.capacity(), player.getBlastCount(), games, waves);
+        if (isEndless()) {
+            printf(" rows=%llu", static_cast<unsigned long long>(getScrolledRows()));
+        }
+        printf("\n");
+
+        // The first sample is the baseline later samples are held to
+        if (baselineTps == 0) {
+            baselineTps = tps;
+            baselineRss = rss;
+            continue;
+        }
+        if (tps < baselineTps * (1 - config.maxThroughputDrop)) {
+            printf("Soak failed: throughput dropped from %.0f to %.0f ticks per second\n", baselineTps, tps);
+            reportMemoryUsage();
+            return 1;
+        }
+        if (baselineRss >= 0 && rss >= 0 && rss - baselineRss > config.maxRssGrowthMb * 1024 * 1024) {
+            printf("Soak failed: resident memory grew by %.1fMB\n", (rss - baselineRss) / (1024.0 * 1024.0));
+            reportMemoryUsage();
+            return 1;
+        }
+    }
+
+    printf("Soak passed: %ld games, %ld waves\n", games, waves);
+    saveConfiguredLevel();
+    reportMemoryUsage();
+    return 0;
+}
@@ -1,71 +1,67 @@
 #include "spider.h"
+#include "animation.h"
+#include "fieldLayer.h"
+#include "memoryTracker.h"
+#include "renderBackend.h"
+#include "simulation.h"
 
 std::vector<Texture> spiderTextures;
 Spider spider(0);
 
 void spiderInit(int initialSpeed) {
+    MemoryScope scope(Subsystem::TEXTURES);
+
     // Load the spider textures
     std::vector<std::string> spiderFileNames = {"assets/textures/Spider0.png", "assets/textures/Spider1.png"};
-    for (const auto& fileName : spiderFileNames) {
-        Texture texture;
-        if (!texture.loadFromFile(fileName)) {
-            printf("Failed to load texture from %s\n", fileName.c_str());
+    spiderTextures = std::vector<Texture>(spiderFileNames.size());
+    for (size_t i = 0; i < spiderFileNames.size(); i++) {
+        if (!loadTexture(spiderTextures[i], spiderFileNames[i])) {
+            printf("Failed to load texture from %s\n", spiderFileNames[i].c_str());
         }
-        spiderTextures.push_back(texture);
     }
 
     // Initialize the spider
     spider = Spider(initialSpeed);
-    spider.setTexture(spiderTextures[0]);
 }
 
 Spider::Spider(int initialSpeed) {
-    animationTick = 0;
-    speed = initialSpeed;
+    // The global spider is constructed before the textures are loaded, and sized once spiderInit() replaces it
+    Vector2u size = spiderTextures.empty() ? Vector2u() : getTextureSize(spiderTextures[0]);
+    entity = entities.create();
+    entities.placements.insert(entity, {});
+    entities.colliders.insert(entity, {toFixed(size.x), toFixed(size.y)});
+    entities.healths.insert(entity, {1});
+    entities.renderables.insert(entity, {spiderTextures.empty() ? nullptr : &spiderTextures[0]});
+    entities.animations.insert(entity, {&spiderTextures, 10, animationTick});
+    entities.motions.insert(entity, {0, 0, toFixed(initialSpeed)});
     this->initialSpeed = initialSpeed;
-    textureIndex = 0;
-    spawnClock.restart();
-    spawnDelay = 3;
-    status = CharacterStatus::ALIVE;
+    spawnDelay = 3.0f;
     reset();
 }
 
-void Spider::rotateTexture() {
-    if (animationTick % 10 == 0) {
-        textureIndex = (textureIndex + 1) % spiderTextures.size();
-        setTexture(spiderTextures[textureIndex]);
-    }
-    animationTick++;
-}
-
 void Spider::update() {
-    // If the spider is dead, reset it after the spawn delay
-    if (status == CharacterStatus::DEAD && spawnClock.getElapsedTime().asSeconds() > spawnDelay) {
-        spider.reset(false);
-    } else if (status == CharacterStatus::DEAD) {
-        return;
-    }
+    MemoryScope scope(Subsystem::SPIDER);
 
-    // Normalize the direction when moving diagonally
-    float magnitude = std::sqrt(dx * dx + dy * dy);
-    if (magnitude > 0) {
-        // Scale dx and dy to ensure the spider's speed is consistent
-        float scale = speed / magnitude;
-        dx *= scale;
-        dy *= scale;
+    // A dead spider waits for its respawn timer
+    if (getStatus() == CharacterStatus::DEAD) {
+        return;
     }
 
     // Update the spider's position
-    setPosition(getPosition().x + dx, getPosition().y + dy);
+    entities.placements.get(entity)->position = getNextPosition();
 
     // Check if the spider will move off the screen and reverse direction if necessary
-    Vector2f nextPosition = getNextPosition();
+    Motion& motion = *entities.motions.get(entity);
+    int& dx = motion.dx;
+    int& dy = motion.dy;
+    FixedVec nextPosition = getNextPosition();
+    FixedRect bounds = getFixedBounds();
     // Check horizontal bounds
-    if (nextPosition.x < 0 || nextPosition.x + getGlobalBounds().width > windowWidth) {
+    if (nextPosition.x < 0 || nextPosition.x + bounds.width > toFixed(windowWidth)) {
         dx = -dx;
     }
     // Check vertical bounds
-    if (nextPosition.y < 0.5f * windowHeight || nextPosition.y + getGlobalBounds().height > windowHeight) {
+    if (nextPosition.y < toFixed(windowHeight) / 2 || nextPosition.y + bounds.height > toFixed(windowHeight)) {
         dy = -dy;
     }
     
@@ -73,50 +69,61 @@ void Spider::update() {
     if (getRandomChance(2)) {
         changeDirection();
     }
-
-    // Check for collisions with mushrooms
-    checkMushroomCollision();
 }
 
-Vector2f Spider::getNextPosition() {
-    return Vector2f(getPosition().x + dx, getPosition().y + dy);
+FixedVec Spider::getNextPosition() {
+    // Scale diagonal steps by 1 / sqrt(2) so the spider covers the same distance in every direction
+    const Motion& motion = *entities.motions.get(entity);
+    Fixed step = (motion.dx != 0 && motion.dy != 0) ? fixedMul(motion.speed, FIXED_INV_SQRT2) : motion.speed;
+    FixedVec position = entities.placements.get(entity)->position;
+    return {position.x + motion.dx * step, position.y + motion.dy * step};
 }
 
 void Spider::handleCollision() {
-    status = CharacterStatus::DEAD;
-    spawnClock.restart();
+    entities.healths.get(entity)->hitPoints = 0;
+    gameTimers.schedule(respawnTimer, secondsToTicks(spawnDelay), [](void* context) {
+        static_cast<Spider*>(context)->reset(false);
+    }, this);
 }
 
 void Spider::reset(bool resetSpeed) {
-    status = CharacterStatus::ALIVE;
+    respawnTimer.cancel();
+    entities.healths.get(entity)->hitPoints = 1;
 
     // Randomly choose either the left or right side of the screen for the X position
-    float newX = getRandomChance(50) ? 0.0f : windowWidth - getGlobalBounds().width;
+    FixedRect bounds = getFixedBounds();
+    Fixed newX = getRandomChance(50) ? 0 : toFixed(windowWidth) - bounds.width;
     // Y position is randomly selected in the bottom portion of the screen
-    float newY = getRandomFloat(windowHeight * 0.5f, windowHeight - getGlobalBounds().height);
+    Fixed newY = getRandomFixed(toFixed(windowHeight) / 2, toFixed(windowHeight) - bounds.height);
     // Set the new position
-    setPosition(newX, newY);
+    entities.placements.get(entity)->position = {newX, newY};
 
     // Determine the initial direction: move towards the center of the screen
-    dx = (newX == 0.0f) ? 1 : -1;
+    Motion& motion = *entities.motions.get(entity);
+    int& dx = motion.dx;
+    int& dy = motion.dy;
+    dx = (newX == 0) ? 1 : -1;
 
     // Set a random vertical direction (-1, 0, or 1)
     dy = getRandomDirection();
     
     // Ensure the spider always moves
     if (dy == 0 && dx == 0) {
-        dx = (newX == 0.0f) ? 1 : -1;
+        dx = (newX == 0) ? 1 : -1;
         dy = dx;
     }
 
     // Reset the speed if specified
     if (resetSpeed) {
-        speed = initialSpeed;
+        motion.speed = toFixed(initialSpeed);
     }
 }
 
 void Spider::changeDirection() {
     // Randomly set the horizontal and vertical direction (-1, 0, or 1)
+    Motion& motion = *entities.motions.get(entity);
+    int& dx = motion.dx;
+    int& dy = motion.dy;
     dx = getRandomDirection();
     dy = getRandomDirection();
 
@@ -127,42 +134,47 @@ void Spider::changeDirection() {
     }
 }
 
-void Spider::checkMushroomCollision() {
-    for (Mushroom& mushroom : mushrooms) {
-        if (getGlobalBounds().intersects(mushroom.getGlobalBounds())) {
-            mushroom.setHealth(0);
+void Spider::detectMeals(CollisionQueue& events) {
+    if (getStatus() == CharacterStatus::DEAD) {
+        return;
+    }
+
+    // Report every mushroom the spider overlaps, the spider is large enough to cover several at once
+    const BoxArray& mushroomBoxes = getMushroomBoxes();
+    hitMask.resize(mushroomBoxes.maskWords());
+    mushroomBoxes.hitMask(getFixedBounds(), hitMask.data());
+    for (size_t word = 0; word < hitMask.size(); ++word) {
+        uint64_t bits = hitMask[word];
+        for (size_t bit = 0; bits != 0; ++bit, bits >>= 1) {
+            if (bits & 1) {
+                events.push({CollisionKind::SPIDER_MEAL, Entity{}, mushrooms.entityAt(mushroomBoxes.getId(word * 64 + bit))});
+            }
         }
     }
 }
 
 void Spider::draw() {
-    if (status == CharacterStatus::DEAD) {
-        return;
-    }
-    rotateTexture();
-    window.draw(*this);
+    // A dead spider has no health left, so the render system skips it
+    animateEntities(entities);
+    batch.clear();
+    batchEntities(entities, batch);
+    drawBatch(batch);
 }
 
 int getRandomDirection() {
     // Generate a random int between -1 and 1
-    static std::random_device rd;
-    static std::mt19937 gen(rd());
     std::uniform_int_distribution<int> dist(-1, 1);
-    return dist(gen);
+    return dist(getSimulationRandom());
 }
 
 bool getRandomChance(int percentage) {
     // Generate a random int between 1 and 100
-    static std::random_device rd;
-    static std::mt19937 gen(rd());
     std::uniform_int_distribution<int> dist(1, 100);
-    return dist(gen) <= percentage;
+    return dist(getSimulationRandom()) <= percentage;
 }
 
-float getRandomFloat(float min, float max) {
-    // Generate a random float between min and max
-    static std::random_device rd;
-    static std::mt19937 gen(rd());
-    std::uniform_real_distribution<float> dist(min, max);
-    return dist(gen);
+Fixed getRandomFixed(Fixed min, Fixed max) {
+    // Generate a random fixed-point value between min and max
+    std::uniform_int_distribution<Fixed> dist(min, max);
+    return dist(getSimulationRandom());
 }
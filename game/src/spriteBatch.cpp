@@ -0,0 +1,109 @@
+#include "spriteBatch.h"
+#include <algorithm>
+#include <array>
+#include "renderBackend.h"
+
+const OrientationTransform& getOrientationTransform(Orientation orientation, Vector2u textureSize) {
+    // Textures come in very few sizes, so a short list searched in order is enough
+    using Table = std::array<OrientationTransform, static_cast<size_t>(Orientation::COUNT)>;
+    static std::vector<std::pair<Vector2u, Table>> tables;
+
+    auto it = std::find_if(tables.begin(), tables.end(), [&](const auto& table) {return table.first == textureSize;});
+    if (it == tables.end()) {
+        float width = static_cast<float>(textureSize.x);
+        float height = static_cast<float>(textureSize.y);
+        Table table;
+        // Left flips the texture horizontally, down and up rotate it, keeping it over the same box
+        table[static_cast<size_t>(Orientation::LEFT)] = {0.0f, Vector2f(-1.0f, 1.0f), Vector2f(width, 0.0f)};
+        table[static_cast<size_t>(Orientation::DOWN)] = {90.0f, Vector2f(1.0f, 1.0f), Vector2f(0.0f, height)};
+        table[static_cast<size_t>(Orientation::UP)] = {-90.0f, Vector2f(1.0f, 1.0f), Vector2f(width, 0.0f)};
+        tables.emplace_back(textureSize, table);
+        it = tables.end() - 1;
+    }
+    return it->second[static_cast<size_t>(orientation)];
+}
+
+void SpriteBatch::clear() {
+    for (Layer& layer : layers) {
+        layer.quads.clear();
+    }
+}
+
+void SpriteBatch::add(const Texture& texture, const Vector2f& position, Orientation orientation) {
+    Layer* layer = nullptr;
+    for (Layer& candidate : layers) {
+        if (candidate.texture == &texture) {
+            layer = &candidate;
+            break;
+        }
+    }
+    if (!layer) {
+        layers.push_back({&texture, VertexArray(Quads)});
+        layer = &layers.back();
+    }
+
+    Vector2f size(getTextureSize(texture));
+    if (orientation == Orientation::NONE || orientation == Orientation::RIGHT) {
+        layer->quads.append(Vertex(position, Vector2f(0, 0)));
+        layer->quads.append(Vertex(Vector2f(position.x + size.x, position.y), Vector2f(size.x, 0)));
+        layer->quads.append(Vertex(position + size, size));
+        layer->quads.append(Vertex(Vector2f(position.x, position.y + size.y), Vector2f(0, size.y)));
+        return;
+    }
+
+    // Turned quads keep their texture coordinates and move their corners
+    const OrientationTransform& turn = getOrientationTransform(orientation, getTextureSize(texture));
+    Transform transform;
+    transform.translate(position.x, position.y).rotate(turn.rotation).scale(turn.scale.x, turn.scale.y).translate(-turn.origin.x, -turn.origin.y);
+    layer->quads.append(Vertex(transform.transformPoint(0, 0), Vector2f(0, 0)));
+    layer->quads.append(Vertex(transform.transformPoint(size.x, 0), Vector2f(size.x, 0)));
+    layer->quads.append(Vertex(transform.transformPoint(size), size));
+    layer->quads.append(Vertex(transform.transformPoint(0, size.y), Vector2f(0, size.y)));
+}
+
+void SpriteBatch::draw(RenderTarget& target) const {
+    for (const Layer& layer : layers) {
+        if (layer.quads.getVertexCount() > 0) {
+            target.draw(layer.quads, RenderStates(layer.texture));
+        }
+    }
+}
+
+void SpriteBatch::draw(Framebuffer& target) const {
+    // The rasterizer works in transforms, recovered from each quad's first, second and last corners
+    for (const Layer& layer : layers) {
+        for (size_t i = 0; i < layer.quads.getVertexCount(); i += 4) {
+            Vector2f origin = layer.quads[i].position;
+            Vector2f size = layer.quads[i + 2].texCoords;
+            Vector2f across = layer.quads[i + 1].position - origin;
+            Vector2f down = layer.quads[i + 3].position - origin;
+            target.draw(*layer.texture, Transform(across.x / size.x, down.x / size.y, origin.x, across.y / size.x, down.y / size.y, origin.y, 0, 0, 1));
+        }
+    }
+}
+
+size_t SpriteBatch::size() const {
+    size_t quads = 0;
+    for (const Layer& layer : layers) {
+        quads += layer.quads.getVertexCount() / 4;
+    }
+    return quads;
+}
+
+void batchEntities(const EntityStore& store, SpriteBatch& batch, const FloatRect* area) {
+    for (size_t i = 0; i < store.renderables.size(); ++i) {
+        Entity entity = store.renderables.entityAt(i);
+        const Placement* placement = store.placements.get(entity);
+        const Health* health = store.healths.get(entity);
+        if (!placement || (health && health->hitPoints <= 0)) {
+            continue;
+        }
+
+        const Renderable& renderable = store.renderables[i];
+        Vector2f position = placement->position.toFloat();
+        if (area && !area->intersects(FloatRect(position, Vector2f(getTextureSize(*renderable.texture))))) {
+            continue;
+        }
+        batch.add(*renderable.texture, position, renderable.orientation);
+    }
+}
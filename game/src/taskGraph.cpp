@@ -0,0 +1,83 @@
+#include "taskGraph.h"
+#include "threadPool.h"
+
+static const char* resourceNames[RES_COUNT] = {"player", "lives", "score", "blasts", "centipede", "mushrooms", "spider", "field layer", "hud", "frame arena", "timers", "player hits", "blast hits", "spider meals"};
+
+void TaskGraph::addTask(const char* name, uint32_t reads, uint32_t writes, std::function<void()> body) {
+    Task& task = tasks.emplace_back();
+    task.name = name;
+    task.reads = reads;
+    task.writes = writes;
+    task.body = std::move(body);
+
+    // Depend on every earlier task that writes what this one touches, or reads what it writes
+    size_t index = tasks.size() - 1;
+    for (size_t i = 0; i < index; ++i) {
+        Task& earlier = tasks[i];
+        uint32_t conflicts = (earlier.writes & (reads | writes)) | (earlier.reads & writes);
+        if (conflicts != 0) {
+            earlier.successors.push_back(index);
+            earlier.successorResources.push_back(conflicts);
+            task.dependencyCount++;
+        }
+    }
+}
+
+void TaskGraph::runTask(void* context, size_t index) {
+    TaskGraph& graph = *static_cast<TaskGraph*>(context);
+    Task& task = graph.tasks[index];
+
+    std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+    task.body();
+    task.totalTime += std::chrono::steady_clock::now() - start;
+    task.runs++;
+
+    for (size_t successor : task.successors) {
+        if (graph.tasks[successor].remaining.fetch_sub(1) == 1) {
+            ThreadPool::instance().submit({runTask, &graph, successor});
+        }
+    }
+    graph.pending.fetch_sub(1);
+}
+
+void TaskGraph::run() {
+    for (Task& task : tasks) {
+        task.remaining = task.dependencyCount;
+    }
+    pending = tasks.size();
+
+    // Queue the tasks with no dependencies, the rest are queued as their dependencies finish
+    ThreadPool& pool = ThreadPool::instance();
+    for (size_t i = 0; i < tasks.size(); ++i) {
+        if (tasks[i].dependencyCount == 0) {
+            pool.submit({runTask, this, i});
+        }
+    }
+    pool.helpUntilDone(pending);
+}
+
+void TaskGraph::writeDot(FILE* file) const {
+    fprintf(file, "digraph frame {\n");
+    fprintf(file, "    rankdir=LR;\n");
+    fprintf(file, "    node [shape=box];\n");
+    for (size_t i = 0; i < tasks.size(); ++i) {
+        const Task& task = tasks[i];
+        double averageMs = (task.runs > 0) ? std::chrono::duration<double, std::milli>(task.totalTime).count() / task.runs : 0.0;
+        fprintf(file, "    t%zu [label=\"%s\\n%.3f ms\"];\n", i, task.name, averageMs);
+    }
+    for (size_t i = 0; i < tasks.size(); ++i) {
+        const Task& task = tasks[i];
+        for (size_t j = 0; j < task.successors.size(); ++j) {
+            fprintf(file, "    t%zu -> t%zu [label=\"", i, task.successors[j]);
+            const char* separator = "";
+            for (uint32_t resource = 0; resource < RES_COUNT; ++resource) {
+                if (task.successorResources[j] & (1u << resource)) {
+                    fprintf(file, "%s%s", separator, resourceNames[resource]);
+                    separator = ", ";
+                }
+            }
+            fprintf(file, "\"];\n");
+        }
+    }
+    fprintf(file, "}\n");
+}
@@ -0,0 +1,146 @@
+#include "telemetry.h"
+#include <algorithm>
+#include <condition_variable>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <mutex>
+#include <thread>
+#include <vector>
+#include "boxArray.h"
+#include "centipede.h"
+#include "laserBlaster.h"
+#include "mushroom.h"
+#include "simulation.h"
+
+static const size_t telemetryBufferRecords = 4096; ///< Records per buffer, about a minute at 60 ticks per second.
+
+static FILE* telemetryFile = nullptr; ///< The stream being written, or null when telemetry is disabled.
+static const char* telemetryPath = nullptr; ///< The path of the stream.
+static std::vector<TelemetryRecord> buffers[2]; ///< The buffer being filled and the one being written.
+static int fillIndex = 0; ///< The buffer the game thread appends to.
+static bool writePending = false; ///< Whether the other buffer is waiting for or being written by the writer.
+static bool stopping = false; ///< Whether the writer should exit once idle.
+static std::mutex telemetryMutex; ///< Guards fillIndex, writePending and stopping.
+static std::condition_variable telemetryWake; ///< Wakes the writer when a buffer is handed over or on shutdown.
+static std::thread writerThread; ///< Writes handed over buffers to the file.
+static uint32_t nextTick = 0; ///< The tick number of the next record.
+static uint64_t lastTestCount = 0; ///< The box test count at the end of the previous tick.
+static long recordsWritten = 0; ///< Records written to the file.
+static long recordsDropped = 0; ///< Records dropped because both buffers were full.
+
+/**
+ * @brief Writes each handed over buffer to the file until shutdown.
+ */
+static void writerLoop() {
+    std::unique_lock<std::mutex> lock(telemetryMutex);
+    while (true) {
+        telemetryWake.wait(lock, [] {return writePending || stopping;});
+        if (!writePending) {
+            return;
+        }
+
+        // The game thread never touches a pending buffer, so it is written without the lock
+        std::vector<TelemetryRecord>& buffer = buffers[fillIndex ^ 1];
+        lock.unlock();
+        size_t written = fwrite(buffer.data(), sizeof(TelemetryRecord), buffer.size(), telemetryFile);
+        buffer.clear();
+        lock.lock();
+        recordsWritten += static_cast<long>(written);
+        writePending = false;
+    }
+}
+
+void parseTelemetryArgs(int argc, char* argv[]) {
+    for (int i = 1; i + 1 < argc; ++i) {
+        if (strcmp(argv[i], "--telemetry") == 0) {
+            telemetryPath = argv[++i];
+        }
+    }
+}
+
+void telemetryInit() {
+    if (!telemetryPath || telemetryFile) {
+        return;
+    }
+
+    telemetryFile = fopen(telemetryPath, "wb");
+    if (!telemetryFile) {
+        printf("Failed to open telemetry file %s\n", telemetryPath);
+        return;
+    }
+    TelemetryHeader header = {{'C', 'P', 'T', 'L'}, telemetryVersion, sizeof(TelemetryRecord), PHASE_COUNT};
+    fwrite(&header, sizeof(header), 1, telemetryFile);
+    buffers[0].reserve(telemetryBufferRecords);
+    buffers[1].reserve(telemetryBufferRecords);
+    BoxArray::setTestCounting(true);
+    lastTestCount = BoxArray::getTestCount();
+    writerThread = std::thread(writerLoop);
+
+    // Every way out of the program, early error returns included, stops the writer before the thread is destroyed
+    std::atexit(telemetryShutdown);
+}
+
+bool isTelemetryEnabled() {
+    return telemetryFile != nullptr;
+}
+
+void recordTelemetryTick(uint8_t screen, const TelemetryPhases& phases) {
+    if (!telemetryFile) {
+        return;
+    }
+
+    TelemetryRecord record;
+    uint64_t testCount = BoxArray::getTestCount();
+    record.tick = nextTick++;
+    record.screen = screen;
+    record.lives = static_cast<uint8_t>(std::max(0, std::min(player.getLives(), 255)));
+    record.wave = static_cast<uint16_t>(getWave());
+    record.segments = static_cast<uint32_t>(centipede.getLiveCount());
+    record.mushrooms = static_cast<uint32_t>(mushrooms.size());
+    record.blasts = static_cast<uint32_t>(player.getBlastCount());
+    record.collisionTests = static_cast<uint32_t>(std::min<uint64_t>(testCount - lastTestCount, UINT32_MAX));
+    record.score = player.getScore();
+    std::copy(phases.phaseMicros, phases.phaseMicros + PHASE_COUNT, record.phaseMicros);
+    lastTestCount = testCount;
+
+    std::vector<TelemetryRecord>& buffer = buffers[fillIndex];
+    buffer.push_back(record);
+    if (buffer.size() < telemetryBufferRecords) {
+        return;
+    }
+
+    // Hand the full buffer to the writer, or drop it if the writer is still busy with the other one
+    {
+        std::lock_guard<std::mutex> lock(telemetryMutex);
+        if (writePending) {
+            recordsDropped += static_cast<long>(buffer.size());
+            buffer.clear();
+            return;
+        }
+        writePending = true;
+        fillIndex ^= 1;
+    }
+    telemetryWake.notify_one();
+}
+
+void telemetryShutdown() {
+    if (!telemetryFile) {
+        return;
+    }
+    {
+        std::lock_guard<std::mutex> lock(telemetryMutex);
+        stopping = true;
+    }
+    telemetryWake.notify_one();
+    writerThread.join();
+
+    // The writer has finished, so the partly filled buffer is written here
+    std::vector<TelemetryRecord>& buffer = buffers[fillIndex];
+    recordsWritten += static_cast<long>(fwrite(buffer.data(), sizeof(TelemetryRecord), buffer.size(), telemetryFile));
+    buffer.clear();
+    fclose(telemetryFile);
+    telemetryFile = nullptr;
+    BoxArray::setTestCounting(false);
+    printf("Telemetry: %ld records written to %s, %ld dropped\n", recordsWritten, telemetryPath, recordsDropped);
+}
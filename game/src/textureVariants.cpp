@@ -0,0 +1,128 @@
+#include "textureVariants.h"
+#include <array>
+#include <atomic>
+#include <cstdint>
+#include <cstdio>
+#include <vector>
+#include "memoryTracker.h"
+#include "renderBackend.h"
+#include "threadPool.h"
+
+/**
+ * @struct VariantTexture
+ * @brief A registered texture and the pixels of its variants.
+ */
+struct VariantTexture {
+    Texture* texture; ///< The texture the selected variant is uploaded into.
+    std::array<std::vector<Uint8>, textureVariantCount> pixels; ///< The RGBA pixels of every built variant, empty until built.
+};
+
+static std::vector<VariantTexture> variantTextures; ///< Every registered texture.
+static std::array<bool, textureVariantCount> variantBuilt = {true}; ///< Whether each variant's pixels are complete.
+static int buildingVariant = -1; ///< The variant being built on the thread pool, or -1.
+static std::atomic<size_t> buildsPending{0}; ///< Textures of buildingVariant not yet built.
+static int selectedVariant = 0; ///< The variant uploaded into the textures.
+static int readySelections = 0; ///< Selections whose variant was already built.
+static int waitingSelections = 0; ///< Selections that had to build or wait for their variant.
+
+/**
+ * @brief Builds one texture's pixels of the variant in flight by rotating its variant 0 channels.
+ *
+ * Only writes storage allocated by prefetchTextureVariant(), so it never allocates.
+ *
+ * @param context The variant index, cast to a pointer.
+ * @param index The registered texture.
+ */
+static void buildVariant(void* context, size_t index) {
+    int variant = static_cast<int>(reinterpret_cast<intptr_t>(context));
+    const std::vector<Uint8>& source = variantTextures[index].pixels[0];
+    std::vector<Uint8>& target = variantTextures[index].pixels[variant];
+    for (size_t i = 0; i + 3 < source.size(); i += 4) {
+        // Each rotation moves blue into red, red into green and green into blue
+        Uint8 channels[3] = {source[i], source[i + 1], source[i + 2]};
+        for (int c = 0; c < 3; ++c) {
+            target[i + c] = channels[(c + 3 - variant % 3) % 3];
+        }
+        target[i + 3] = source[i + 3];
+    }
+    buildsPending.fetch_sub(1, std::memory_order_release);
+}
+
+/**
+ * @brief Waits for the variant in flight, if any, helping to build it.
+ */
+static void finishPrefetch() {
+    if (buildingVariant < 0) {
+        return;
+    }
+    ThreadPool::instance().helpUntilDone(buildsPending);
+    variantBuilt[buildingVariant] = true;
+    buildingVariant = -1;
+}
+
+void addTextureVariants(Texture& texture) {
+    MemoryScope scope(Subsystem::TEXTURES);
+    finishPrefetch();
+    VariantTexture variantTexture;
+    variantTexture.texture = &texture;
+    Image image = copyTextureImage(texture);
+    const Uint8* pixels = image.getPixelsPtr();
+    if (pixels) {
+        variantTexture.pixels[0].assign(pixels, pixels + 4 * image.getSize().x * image.getSize().y);
+    }
+    variantTextures.push_back(std::move(variantTexture));
+
+    // Variants built before this texture was registered lack it
+    for (int variant = 1; variant < textureVariantCount; ++variant) {
+        variantBuilt[variant] = false;
+    }
+}
+
+void prefetchTextureVariant(int index) {
+    if (variantBuilt[index] || buildingVariant == index) {
+        return;
+    }
+    finishPrefetch();
+
+    // Allocate here so the pool jobs only fill in pixels
+    MemoryScope scope(Subsystem::TEXTURES);
+    for (VariantTexture& variantTexture : variantTextures) {
+        variantTexture.pixels[index].resize(variantTexture.pixels[0].size());
+    }
+    buildingVariant = index;
+    buildsPending.store(variantTextures.size(), std::memory_order_relaxed);
+    ThreadPool& pool = ThreadPool::instance();
+    for (size_t i = 0; i < variantTextures.size(); ++i) {
+        pool.submit({buildVariant, reinterpret_cast<void*>(static_cast<intptr_t>(index)), i});
+    }
+}
+
+void selectTextureVariant(int index) {
+    bool ready = variantBuilt[index] || (buildingVariant == index && buildsPending.load(std::memory_order_acquire) == 0);
+    (ready ? readySelections : waitingSelections)++;
+    if (!variantBuilt[index]) {
+        prefetchTextureVariant(index);
+        finishPrefetch();
+    }
+
+    for (VariantTexture& variantTexture : variantTextures) {
+        if (!variantTexture.pixels[index].empty()) {
+            updateTexture(*variantTexture.texture, variantTexture.pixels[index].data());
+        }
+    }
+    selectedVariant = index;
+    prefetchTextureVariant((index + 1) % textureVariantCount);
+}
+
+int getTextureVariant() {
+    return selectedVariant;
+}
+
+void reportTextureVariants() {
+    int built = 0;
+    for (bool variant : variantBuilt) {
+        built += variant;
+    }
+    printf("Texture variants: %d of %d built for %zu textures, %d selections ready, %d waited for their variant\n",
+        built, textureVariantCount, variantTextures.size(), readySelections, waitingSelections);
+}
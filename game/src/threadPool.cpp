@@ -0,0 +1,115 @@
+#include "threadPool.h"
+
+static const size_t externalQueue = SIZE_MAX; ///< Marks threads that are not pool workers.
+static thread_local size_t workerQueue = externalQueue; ///< The queue owned by the calling worker.
+
+ThreadPool& ThreadPool::instance() {
+    static ThreadPool pool;
+    return pool;
+}
+
+ThreadPool::ThreadPool() {
+    unsigned int workerCount = std::thread::hardware_concurrency();
+    workerCount = (workerCount > 1) ? workerCount - 1 : 0;
+    queues = std::vector<JobQueue>(workerCount + 1);
+    for (unsigned int i = 0; i < workerCount; ++i) {
+        workers.emplace_back(&ThreadPool::workerLoop, this, i);
+    }
+}
+
+ThreadPool::~ThreadPool() {
+    {
+        std::lock_guard<std::mutex> lock(sleepMutex);
+        stopping = true;
+    }
+    wake.notify_all();
+    for (std::thread& worker : workers) {
+        worker.join();
+    }
+}
+
+size_t ThreadPool::ownQueue() const {
+    return (workerQueue == externalQueue) ? queues.size() - 1 : workerQueue;
+}
+
+void ThreadPool::submit(const PoolJob& job) {
+    JobQueue& queue = queues[ownQueue()];
+    std::unique_lock<std::mutex> lock(queue.mutex);
+    if (queue.count == queueCapacity) {
+        // The queue is full, so run the job inline rather than dropping it
+        lock.unlock();
+        job.run(job.context, job.index);
+        return;
+    }
+    queue.jobs[(queue.head + queue.count) % queueCapacity] = job;
+    queue.count++;
+    queuedJobs.fetch_add(1);
+    lock.unlock();
+
+    // Take the sleep lock so a worker checking for jobs cannot miss the wake up
+    {
+        std::lock_guard<std::mutex> sleepLock(sleepMutex);
+    }
+    wake.notify_one();
+}
+
+bool ThreadPool::findJob(size_t queueIndex, PoolJob& job) {
+    if (queuedJobs.load() == 0) {
+        return false;
+    }
+
+    // Newest job from the thread's own queue first, it is the most likely to be cache-warm
+    {
+        JobQueue& queue = queues[queueIndex];
+        std::lock_guard<std::mutex> lock(queue.mutex);
+        if (queue.count > 0) {
+            queue.count--;
+            job = queue.jobs[(queue.head + queue.count) % queueCapacity];
+            queuedJobs.fetch_sub(1);
+            return true;
+        }
+    }
+
+    // Then the oldest job from any other queue
+    for (size_t offset = 1; offset < queues.size(); ++offset) {
+        JobQueue& queue = queues[(queueIndex + offset) % queues.size()];
+        std::lock_guard<std::mutex> lock(queue.mutex);
+        if (queue.count > 0) {
+            job = queue.jobs[queue.head];
+            queue.head = (queue.head + 1) % queueCapacity;
+            queue.count--;
+            queuedJobs.fetch_sub(1);
+            return true;
+        }
+    }
+    return false;
+}
+
+void ThreadPool::helpUntilDone(const std::atomic<size_t>& pending) {
+    size_t queueIndex = ownQueue();
+    PoolJob job;
+    while (pending.load() > 0) {
+        if (findJob(queueIndex, job)) {
+            job.run(job.context, job.index);
+        } else {
+            std::this_thread::yield();
+        }
+    }
+}
+
+void ThreadPool::workerLoop(size_t queueIndex) {
+    workerQueue = queueIndex;
+    PoolJob job;
+    while (true) {
+        if (findJob(queueIndex, job)) {
+            job.run(job.context, job.index);
+            continue;
+        }
+
+        std::unique_lock<std::mutex> lock(sleepMutex);
+        wake.wait(lock, [this] {return stopping || queuedJobs.load() > 0;});
+        if (stopping) {
+            return;
+        }
+    }
+}
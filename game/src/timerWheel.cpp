@@ -0,0 +1,87 @@
+#include "timerWheel.h"
+#include <cmath>
+
+TimerWheel gameTimers;
+
+void Timer::cancel() {
+    if (!wheel) {
+        return;
+    }
+    *link = next;
+    if (next) {
+        next->link = link;
+    }
+    wheel->pendingCount--;
+    wheel = nullptr;
+    next = nullptr;
+    link = nullptr;
+}
+
+void TimerWheel::schedule(Timer& timer, uint32_t delay, void (*callback)(void*), void* context) {
+    timer.cancel();
+    timer.callback = callback;
+    timer.context = context;
+
+    // Delays past the last level are clamped to the longest delay the wheel can hold
+    const uint64_t longest = (uint64_t(1) << (levels * levelBits)) - 1;
+    uint64_t ticks = (delay < 1) ? 1 : delay;
+    timer.expires = tick + ((ticks > longest) ? longest : ticks);
+    insert(timer);
+    pendingCount++;
+}
+
+void TimerWheel::insert(Timer& timer) {
+    // Pick the first level whose slots still tell the expiry tick apart from the current one
+    uint64_t delay = timer.expires - tick;
+    int level = 0;
+    while (level < levels - 1 && delay >= (uint64_t(1) << ((level + 1) * levelBits))) {
+        level++;
+    }
+    Timer** head = &heads[level][(timer.expires >> (level * levelBits)) & (slots - 1)];
+
+    // Push the timer onto the front of the slot's list
+    timer.next = *head;
+    if (timer.next) {
+        timer.next->link = &timer.next;
+    }
+    timer.link = head;
+    timer.wheel = this;
+    *head = &timer;
+}
+
+void TimerWheel::cascade(int level, int slot) {
+    // Detach the list first, every timer lands in a lower level
+    Timer* timer = heads[level][slot];
+    heads[level][slot] = nullptr;
+    while (timer) {
+        Timer* next = timer->next;
+        insert(*timer);
+        timer = next;
+    }
+}
+
+void TimerWheel::advance() {
+    tick++;
+
+    // Every time a level wraps around, bring the next slot of the level above down
+    for (int level = 1; level < levels; ++level) {
+        if ((tick & ((uint64_t(1) << (level * levelBits)) - 1)) != 0) {
+            break;
+        }
+        cascade(level, (tick >> (level * levelBits)) & (slots - 1));
+    }
+
+    // Every timer left in the current level 0 slot expires now
+    Timer*& head = heads[0][tick & (slots - 1)];
+    while (head) {
+        Timer& timer = *head;
+        timer.cancel();
+        if (timer.callback) {
+            timer.callback(timer.context);
+        }
+    }
+}
+
+uint32_t secondsToTicks(float seconds) {
+    return static_cast<uint32_t>(std::lround(seconds * gameTicksPerSecond));
+}
@@ -0,0 +1,208 @@
+/**
+ * @file telemetryDump.cpp
+ * @brief Converts a telemetry stream written with --telemetry to CSV or summary statistics.
+ *
+ * Usage: TelemetryDump <stream> [--csv]
+ *
+ * Without --csv, prints the distribution of every field, the slowest ticks
+ * with the game state they ran in, and how strongly tick time correlates with
+ * each entity count.
+ */
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include <cstring>
+#include <vector>
+#include "telemetry.h"
+
+static const char* phaseNames[PHASE_COUNT] = {"simulate_us", "draw_us", "present_us"}; ///< The CSV column of each phase.
+
+/**
+ * @struct Column
+ * @brief A numeric field of every record, for the summary.
+ */
+struct Column {
+    const char* name; ///< The field name.
+    std::vector<double> values; ///< The field of every record, in tick order.
+};
+
+/**
+ * @brief Reads and validates a telemetry stream.
+ *
+ * @param path The path of the stream.
+ * @param records Receives the records.
+ * @return true if the stream was valid, false otherwise.
+ */
+static bool readStream(const char* path, std::vector<TelemetryRecord>& records) {
+    FILE* file = fopen(path, "rb");
+    if (!file) {
+        printf("Failed to open %s\n", path);
+        return false;
+    }
+    TelemetryHeader header;
+    bool valid = fread(&header, sizeof(header), 1, file) == 1 && memcmp(header.magic, "CPTL", 4) == 0;
+    if (!valid || header.version != telemetryVersion || header.recordSize != sizeof(TelemetryRecord) || header.phaseCount != PHASE_COUNT) {
+        printf("%s is not a version %u telemetry stream\n", path, telemetryVersion);
+        fclose(file);
+        return false;
+    }
+    TelemetryRecord record;
+    while (fread(&record, sizeof(record), 1, file) == 1) {
+        records.push_back(record);
+    }
+    fclose(file);
+    return true;
+}
+
+/**
+ * @brief Returns the total time of a tick.
+ *
+ * @param record The tick's record.
+ * @return double The sum of its phase timings in microseconds.
+ */
+static double tickMicros(const TelemetryRecord& record) {
+    double total = 0;
+    for (uint32_t micros : record.phaseMicros) {
+        total += micros;
+    }
+    return total;
+}
+
+/**
+ * @brief Prints every record as a CSV row under a header row.
+ *
+ * @param records The records.
+ */
+static void printCsv(const std::vector<TelemetryRecord>& records) {
+    printf("tick,screen,lives,wave,segments,mushrooms,blasts,collision_tests,score");
+    for (const char* name : phaseNames) {
+        printf(",%s", name);
+    }
+    printf("\n");
+    for (const TelemetryRecord& record : records) {
+        printf("%u,%s,%u,%u,%u,%u,%u,%u,%d", record.tick, record.screen ? "game" : "home", record.lives, record.wave,
+            record.segments, record.mushrooms, record.blasts, record.collisionTests, record.score);
+        for (uint32_t micros : record.phaseMicros) {
+            printf(",%u", micros);
+        }
+        printf("\n");
+    }
+}
+
+/**
+ * @brief Returns the Pearson correlation of two equally long series.
+ *
+ * @param x The first series.
+ * @param y The second series.
+ * @return double The correlation, 0 if either series is constant.
+ */
+static double correlation(const std::vector<double>& x, const std::vector<double>& y) {
+    double meanX = 0, meanY = 0;
+    for (size_t i = 0; i < x.size(); ++i) {
+        meanX += x[i];
+        meanY += y[i];
+    }
+    meanX /= x.size();
+    meanY /= y.size();
+    double covariance = 0, varianceX = 0, varianceY = 0;
+    for (size_t i = 0; i < x.size(); ++i) {
+        covariance += (x[i] - meanX) * (y[i] - meanY);
+        varianceX += (x[i] - meanX) * (x[i] - meanX);
+        varianceY += (y[i] - meanY) * (y[i] - meanY);
+    }
+    return (varianceX == 0 || varianceY == 0) ? 0 : covariance / std::sqrt(varianceX * varianceY);
+}
+
+/**
+ * @brief Prints the distribution of every field, the slowest ticks and the correlations with tick time.
+ *
+ * @param records The records, at least one.
+ */
+static void printSummary(const std::vector<TelemetryRecord>& records) {
+    std::vector<Column> columns = {{"segments", {}}, {"mushrooms", {}}, {"blasts", {}}, {"collision_tests", {}}};
+    for (const char* name : phaseNames) {
+        columns.push_back({name, {}});
+    }
+    columns.push_back({"tick_us", {}});
+
+    long gameTicks = 0;
+    uint32_t highestWave = 0;
+    int32_t bestScore = 0;
+    for (const TelemetryRecord& record : records) {
+        gameTicks += record.screen;
+        highestWave = std::max<uint32_t>(highestWave, record.wave);
+        bestScore = std::max(bestScore, record.score);
+        columns[0].values.push_back(record.segments);
+        columns[1].values.push_back(record.mushrooms);
+        columns[2].values.push_back(record.blasts);
+        columns[3].values.push_back(record.collisionTests);
+        for (uint32_t phase = 0; phase < PHASE_COUNT; ++phase) {
+            columns[4 + phase].values.push_back(record.phaseMicros[phase]);
+        }
+        columns.back().values.push_back(tickMicros(record));
+    }
+
+    printf("%zu ticks, %ld in games, highest wave %u, best score %d\n", records.size(), gameTicks, highestWave, bestScore);
+    printf("%-16s %10s %10s %10s %10s %10s\n", "field", "min", "mean", "p50", "p99", "max");
+    for (const Column& column : columns) {
+        std::vector<double> sorted = column.values;
+        std::sort(sorted.begin(), sorted.end());
+        double mean = 0;
+        for (double value : sorted) {
+            mean += value;
+        }
+        mean /= sorted.size();
+        printf("%-16s %10.0f %10.1f %10.0f %10.0f %10.0f\n", column.name, sorted.front(), mean,
+            sorted[sorted.size() / 2], sorted[std::min(sorted.size() - 1, sorted.size() * 99 / 100)], sorted.back());
+    }
+
+    // The slowest ticks and the state they ran in
+    std::vector<size_t> order(records.size());
+    for (size_t i = 0; i < order.size(); ++i) {
+        order[i] = i;
+    }
+    size_t shown = std::min<size_t>(10, order.size());
+    std::partial_sort(order.begin(), order.begin() + shown, order.end(), [&](size_t a, size_t b) {
+        return tickMicros(records[a]) > tickMicros(records[b]);
+    });
+    printf("Slowest ticks:\n");
+    for (size_t i = 0; i < shown; ++i) {
+        const TelemetryRecord& record = records[order[i]];
+        printf("  tick %8u %8.0f us  %s wave %u, %u segments, %u mushrooms, %u blasts, %u collision tests\n", record.tick,
+            tickMicros(record), record.screen ? "game" : "home", record.wave, record.segments, record.mushrooms, record.blasts, record.collisionTests);
+    }
+
+    printf("Correlation with tick time:\n");
+    for (size_t i = 0; i < 4; ++i) {
+        printf("  %-16s %6.2f\n", columns[i].name, correlation(columns[i].values, columns.back().values));
+    }
+}
+
+int main(int argc, char* argv[]) {
+    const char* path = nullptr;
+    bool csv = false;
+    for (int i = 1; i < argc; ++i) {
+        if (strcmp(argv[i], "--csv") == 0) {
+            csv = true;
+        } else {
+            path = argv[i];
+        }
+    }
+    if (!path) {
+        printf("Usage: %s <stream> [--csv]\n", argv[0]);
+        return 1;
+    }
+
+    std::vector<TelemetryRecord> records;
+    if (!readStream(path, records)) {
+        return 1;
+    }
+    if (csv) {
+        printCsv(records);
+    } else if (records.empty()) {
+        printf("%s holds no ticks\n", path);
+    } else {
+        printSummary(records);
+    }
+    return 0;
+}